@@ -0,0 +1,23 @@
+# Timing helper shared by the benches:
+#
+#   Code.require_file("bench_helper.exs", __DIR__)
+#
+defmodule Bench do
+  @doc """
+  Call `fun` n times after a warm up call, and print the rate in `unit`:
+
+    * `:us` - microseconds per call (default)
+    * `:ms` - milliseconds per call
+    * `{:melem, count}` - million elements per second, count elements per call
+  """
+  def run(label, n, fun, unit \\ :us) do
+    fun.()    # warm up
+    {usec, _} = :timer.tc(fn -> Enum.each(1..n, fn _ -> fun.() end) end)
+
+    case unit do
+      :us -> IO.puts(:io_lib.format("~-28s ~10.3f us/call", [label, usec / n]))
+      :ms -> IO.puts(:io_lib.format("~-28s ~10.3f ms/call", [label, usec / n / 1000]))
+      {:melem, count} -> IO.puts(:io_lib.format("~-28s ~10.1f Melem/s", [label, count * n / usec]))
+    end
+  end
+end
@@ -0,0 +1,31 @@
+# Batch log-mel: one call per clip against one batch call on the thread pool.
+#
+#   mix run bench/log_mel_batch.exs
+#
+alias Mozu.FeatureExtractor
+
+Code.require_file("bench_helper.exs", __DIR__)
+
+calls     = 10
+n_samples = 16_000 * 10
+fe        = FeatureExtractor.new(n_fft: 400, hop: 160, n_mels: 80)
+
+for batch <- [8, 32] do
+  clips = for b <- 1..batch do
+    for(i <- 0..(n_samples - 1), into: <<>>, do: <<:math.sin(i * 0.01 * b)::float-32-little>>)
+  end
+  audios = Enum.map(clips, &%Mozu.Audio{channels: 1, sampling: 16_000, wave: &1})
+
+  IO.puts("batch = #{batch}, 10 s clips")
+  Bench.run("  per clip", calls, fn ->
+    Enum.each(audios, &FeatureExtractor.log_mel_spectrogram(fe, &1, true, "<f4"))
+  end, :ms)
+  for size <- [1, 4, 0] do
+    {:ok, threads} = Mozu.Util.thread_pool(size)
+    Bench.run("  batch pool=#{threads}", calls, fn ->
+      FeatureExtractor.log_mel_batch(fe, clips, n_samples)
+    end, :ms)
+  end
+end
+
+Mozu.Util.thread_pool(0)
@@ -0,0 +1,18 @@
+# Real input FFT: pocketfft against the native engine of src/fft.h.
+#
+#   mix run bench/rfft_backend.exs
+#
+alias Mozu.FFT
+
+Code.require_file("bench_helper.exs", __DIR__)
+
+calls = 10_000
+
+for n_fft <- [400, 401, 512, 1000, 4096], dtype <- ["<f4", "<f8"] do
+  frame = for(i <- 0..(n_fft - 1), into: <<>>, do: <<:math.sin(i * 0.1)::float-32-little>>)
+  npy   = %{__struct__: Npy, descr: "<f4", fortran_order: false, shape: {n_fft}, data: frame}
+
+  IO.puts("n_fft = #{n_fft}, dtype = #{dtype}")
+  Bench.run("  pocketfft", calls, fn -> FFT.rfft(npy, dtype: dtype, backend: :pocketfft) end)
+  Bench.run("  native",    calls, fn -> FFT.rfft(npy, dtype: dtype, backend: :native) end)
+end
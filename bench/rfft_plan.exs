@@ -0,0 +1,19 @@
+# Per-frame cost of the real input FFT with and without a reusable plan.
+#
+#   mix run bench/rfft_plan.exs
+#
+alias Mozu.FFT
+
+Code.require_file("bench_helper.exs", __DIR__)
+
+frames = 20_000
+
+for n_fft <- [400, 512] do
+  frame = for(i <- 0..(n_fft - 1), into: <<>>, do: <<:math.sin(i * 0.1)::float-32-little>>)
+  npy   = %{__struct__: Npy, descr: "<f4", fortran_order: false, shape: {n_fft}, data: frame}
+  plan  = FFT.Plan.new(n_fft, "<f4")
+
+  IO.puts("n_fft = #{n_fft}")
+  Bench.run("  rfft (no plan)", frames, fn -> FFT.rfft(npy, dtype: "<f4", power: :norm) end)
+  Bench.run("  rfft (plan)",    frames, fn -> FFT.Plan.rfft(plan, npy, power: :norm) end)
+end
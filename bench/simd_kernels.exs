@@ -0,0 +1,35 @@
+# Throughput of the elementwise kernels on each SIMD backend.
+#
+#   mix run bench/simd_kernels.exs
+#
+alias Mozu.{FFT, Util}
+
+Code.require_file("bench_helper.exs", __DIR__)
+
+count = 1_048_576
+f4  = for(i <- 1..count, into: <<>>, do: <<:math.sin(i * 0.01) * 100::float-32-little>>)
+c8  = %{__struct__: Npy, descr: "<c8",  fortran_order: false, shape: {div(count, 2)}, data: f4}
+c16 = Util.astype(c8, "<c16")
+f4  = %{__struct__: Npy, descr: "<f4",  fortran_order: false, shape: {count}, data: f4}
+f8  = Util.astype(f4, "<f8")
+fe  = Mozu.FeatureExtractor.new(n_fft: 400, hop: 160, n_mels: 80)
+wave = %Mozu.Audio{wave: f4.data}
+
+{:ok, current, supported} = Util.simd_info()
+
+for backend <- supported do
+  Util.simd_backend(backend)
+  IO.puts("#{backend}")
+  Bench.run("  power <c8 :abs", 50, fn -> FFT.power(c8,  :abs)  end, {:melem, div(count, 2)})
+  Bench.run("  power <c8 :norm", 50, fn -> FFT.power(c8,  :norm) end, {:melem, div(count, 2)})
+  Bench.run("  power <c16 :norm", 50, fn -> FFT.power(c16, :norm) end, {:melem, div(count, 2)})
+  Bench.run("  astype <f4 -> <f8", 50, fn -> Util.astype(f4, "<f8") end, {:melem, count})
+  Bench.run("  astype <f8 -> <f4", 50, fn -> Util.astype(f8, "<f4") end, {:melem, count})
+  Bench.run("  astype <c8 -> <c16", 50, fn -> Util.astype(c8, "<c16") end, {:melem, div(count, 2)})
+  Bench.run("  astype <c16 -> <c8", 50, fn -> Util.astype(c16, "<c8") end, {:melem, div(count, 2)})
+  Bench.run("  astype <f4 -> <i4", 50, fn -> Util.astype(f4, "<i4") end, {:melem, count})
+  # log10 is applied to the mel spectrogram in float32.
+  Bench.run("  log-mel <f4 (incl. FFT)", 10, fn -> Mozu.FeatureExtractor.log_mel_spectrogram(fe, wave, true, "<f4") end, {:melem, count})
+end
+
+Util.simd_backend(current)
@@ -10,8 +10,8 @@ defmodule Mozu do
 
   ## Examples
 
-      iex> Mozu.mel_filter_bank(201, 80, 0.0, 8000.0, 16000, :slaney, true)
-      %Npy{descr: "<f8", shape: {201, 80}, data: <<>>}
+      Mozu.mel_filter_bank(201, 80, 0.0, 8000.0, 16000, :slaney, true)
+      #=> %Npy{descr: "<f8", shape: {201, 80}, data: <<...>>}
 
   """
   def mel_filter_bank(n_ferq_bins, n_mel_filters, min_freq, max_freq, sampling_rate, mel_scale \\ :htk, norm \\ false, triangularize_in_mel_space \\ false) do
@@ -27,13 +27,64 @@ defmodule Mozu do
     end
   end
 
+  @doc """
+  Compute log mel spectrogram of mono %Audio{} natively.
+
+  ## Options
+
+    * `:n_fft` - FFT size and window length (default: 400)
+    * `:hop` - hop length between frames (default: 160)
+    * `:n_mels` - number of mel filters (default: 80)
+    * `:min_freq` - lowest frequency of the filter bank (default: 0.0)
+    * `:max_freq` - highest frequency of the filter bank (default: sampling/2)
+    * `:mel_scale` - :htk, :kaldi or :slaney (default: :slaney)
+    * `:norm` - slaney-style area normalization (default: true)
+    * `:center` - reflect pad the wave by n_fft/2 on both sides (default: true)
+    * `:dtype` - "<f4" to compute in float32, "<f8" in float64, "<f2" float32 with float16 output (default: "<f8")
+    * `:normalize` - :log10, :whisper, :db, {:db, top_db} or :kaldi (default: :log10);
+      see `Mozu.FeatureExtractor.log_mel_spectrogram/5`
+
+  ## Examples
+
+      Mozu.log_mel_spectrogram(audio, n_mels: 80)
+      #=> %Npy{descr: "<f8", shape: {80, 3001}, data: <<...>>}
+
+  """
+  def log_mel_spectrogram(%Mozu.Audio{channels: 1, sampling: sampling} = audio, opts \\ []) do
+    {center, opts} = Keyword.pop(opts, :center, true)
+    {dtype, opts}  = Keyword.pop(opts, :dtype, "<f8")
+    {normalize, opts} = Keyword.pop(opts, :normalize, :log10)
+
+    Mozu.FeatureExtractor.new([sampling: sampling] ++ opts)
+    |> Mozu.FeatureExtractor.log_mel_spectrogram(audio, center, dtype, normalize)
+  end
+
+  @doc """
+  Compute MFCC of mono %Audio{} natively.
+
+  The options of the mel filter bank are same as `log_mel_spectrogram/2`,
+  and the options of `Mozu.FeatureExtractor.mfcc/3` are passed through.
+
+  ## Examples
+
+      Mozu.mfcc(audio, n_mfcc: 13, deltas: 2)
+      #=> %Npy{descr: "<f4", shape: {39, 3001}, data: <<...>>}
+
+  """
+  def mfcc(%Mozu.Audio{channels: 1, sampling: sampling} = audio, opts \\ []) do
+    {mfcc_opts, opts} = Keyword.split(opts, [:n_mfcc, :normalize, :lifter, :deltas, :width, :center])
+
+    Mozu.FeatureExtractor.new([sampling: sampling] ++ opts)
+    |> Mozu.FeatureExtractor.mfcc(audio, mfcc_opts)
+  end
+
   @doc """
   Convert frequency from hertz to mels.
 
   ## Examples
 
-      iex> Mozu.hz2mel(freq, :slaney)
-      mel
+      iex> Mozu.hz2mel(1000.0, :slaney)
+      15.0
 
   """
   def hz2mel(freq, mel_scale \\ :htk)
@@ -58,8 +109,8 @@ defmodule Mozu do
 
   ### Examples
 
-      iex> Mozu.mel2hz(mel, :slaney)
-      freq
+      iex> Mozu.mel2hz(15.0, :slaney)
+      1000.0
 
   """
   def mel2hz(freq, mel_scale \\ :htk)
@@ -0,0 +1,134 @@
+defmodule Mozu.Async do
+  @moduledoc """
+  Asynchronous jobs: the work runs on Mozu's native runner threads instead
+  of a (dirty) scheduler, and the result comes back as a message.
+
+      {:ok, job} = Mozu.Async.log_mel_spectrogram(fe, audio)
+      # ... do other things ...
+      {:ok, mel} = Mozu.Async.await(job)
+
+  The native side sends `{:mozu_result, ref, result}` to the submitter,
+  where `ref` is `job.ref`; a GenServer may take it in `handle_info/2` and
+  convert it with `decode/2`.
+
+  The queue is bounded: a submission to the full queue returns
+  `{:error, :busy}` at once, which is the backpressure to the caller.
+  """
+  alias Mozu.{Audio, FeatureExtractor, NIF}
+
+  defstruct ref: nil, decode: nil
+
+  @doc """
+  Submit the call of NIF `name` with `args` (e.g. `:log_mel_spectrogram`).
+  `decode` converts the raw result in `await/2` and `decode/2`.
+  Returns `{:ok, %Mozu.Async{}}` or `{:error, :busy}`.
+
+  The arguments are checked here: invalid ones raise `ArgumentError` as the
+  NIF itself does. Failures found while running, e.g. a file not to be read,
+  come back as `{:error, reason}` in the result.
+  """
+  def submit(name, args, decode \\ &(&1)) do
+    with {:ok, ref} <- NIF.async_submit(name, args) do
+      {:ok, %__MODULE__{ref: ref, decode: decode}}
+    end
+  end
+
+  @doc """
+  Load audio from .wav file asynchronously. The options are same as `Mozu.Audio.load/2`.
+  """
+  def load(path, opts \\ []) do
+    submit(:wav_load, [path, Keyword.get(opts, :layout, :interleaved), opts[:offset], opts[:duration]],
+      &Audio.to_audio/1)
+  end
+
+  @doc """
+  Compute log mel spectrogram asynchronously, see `Mozu.FeatureExtractor.log_mel_spectrogram/5`.
+
+  ## Options
+
+    * `:center` - (default: true)
+    * `:dtype` - (default: "<f8")
+    * `:normalize` - (default: :log10)
+  """
+  def log_mel_spectrogram(%FeatureExtractor{ref: ref, n_mels: n_mels, sampling: sampling},
+                          %Audio{channels: 1, sampling: sampling, wave: wave}, opts \\ []) do
+    center    = Keyword.get(opts, :center, true)
+    dtype     = Keyword.get(opts, :dtype, "<f8")
+    normalize = Keyword.get(opts, :normalize, :log10)
+
+    submit(:log_mel_spectrogram, [ref, wave, center, dtype, normalize],
+      &FeatureExtractor.to_npy(&1, n_mels, dtype))
+  end
+
+  @doc """
+  Compute MFCC asynchronously. The options are same as `Mozu.FeatureExtractor.mfcc/3`.
+  """
+  def mfcc(%FeatureExtractor{ref: ref, sampling: sampling},
+           %Audio{channels: 1, sampling: sampling, wave: wave}, opts \\ []) do
+    n_mfcc    = Keyword.get(opts, :n_mfcc, 13)
+    normalize = Keyword.get(opts, :normalize, :db)
+    lifter    = Keyword.get(opts, :lifter, 0)
+    deltas    = Keyword.get(opts, :deltas, 0)
+    width     = Keyword.get(opts, :width, 2)
+    center    = Keyword.get(opts, :center, true)
+
+    submit(:mfcc, [ref, wave, center, normalize, n_mfcc, lifter, deltas, width],
+      &FeatureExtractor.to_npy(&1, (deltas + 1)*n_mfcc, "<f4"))
+  end
+
+  @doc """
+  Wait for the result of the job. Returns `{:error, :timeout}` after
+  `timeout` ms; the job keeps running, see `cancel/1`.
+  """
+  def await(%__MODULE__{ref: ref} = job, timeout \\ :infinity) do
+    receive do
+      {:mozu_result, ^ref, result} -> decode(job, result)
+    after
+      timeout -> {:error, :timeout}
+    end
+  end
+
+  @doc """
+  Convert the raw result of the `{:mozu_result, ref, result}` message.
+  Plain results are wrapped in `{:ok, _}`; errors are passed through.
+  """
+  def decode(%__MODULE__{decode: decode}, result) do
+    case decode.(result) do
+      {:ok, _} = ok -> ok
+      {:error, _} = error -> error
+      :error -> {:error, :failed}
+      other -> {:ok, other}
+    end
+  end
+
+  @doc """
+  Cancel the job: it is dropped from the queue, or its result is discarded
+  if it is running. No result message of the job comes after this call.
+  """
+  def cancel(%__MODULE__{ref: ref}) do
+    NIF.async_cancel(ref)
+
+    # the result may have been sent before the cancel.
+    receive do
+      {:mozu_result, ^ref, _} -> :ok
+    after
+      0 -> :ok
+    end
+  end
+
+  @doc """
+  Set the number of runner threads (`:runners`, 2 at load) and the queue
+  capacity (`:capacity`, 64 at load); the ones not given are kept.
+  """
+  def configure(opts) do
+    {:ok, {_queued, _running, runners, capacity}} = NIF.async_info()
+
+    NIF.async_config(Keyword.get(opts, :runners, runners), Keyword.get(opts, :capacity, capacity))
+  end
+
+  @doc """
+  Jobs in the queue and running, runner threads and the queue capacity:
+  `{:ok, {queued, running, runners, capacity}}`.
+  """
+  def info(), do: NIF.async_info()
+end
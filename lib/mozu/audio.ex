@@ -8,35 +8,85 @@ defmodule Mozu.Audio do
 
   @doc """
   Load audio from file {.wav,}.
+
+  ## Options
+
+    * `:layout` - channel layout of the decoded wave (default: :interleaved)
+      * `:interleaved` - all channels interleaved in one %Audio{}
+      * `:mono` - downmix to mono
+      * `{:channel, n}` - select channel n (0 origin)
+      * `:split` - list of mono %Audio{}, one per channel
+    * `:offset` - start of the range to load, in frames (integer) or seconds (float) (default: start of file)
+    * `:duration` - length of the range, in frames (integer) or seconds (float) (default: to end of file)
+
+  Only the range is read from the file. A file not to be read as WAV results
+  in `{:error, :invalid_wav}`, a channel beyond the file in
+  `{:error, :invalid_channel}`.
   """
-  def load(path) do
+  def load(path, opts \\ []) do
     loader = case Path.extname(path) do
-      ".wav" -> &NIF.wav_load/1
+      ".wav" -> &NIF.wav_load/4
     end
 
-    with {:ok, {channels, sampling, wave}} <- loader.(path) do
-      {:ok, %__MODULE__{channels: channels, sampling: sampling, wave: wave}}
-    end
+    loader.(path, Keyword.get(opts, :layout, :interleaved), opts[:offset], opts[:duration])
+    |> to_audio()
   end
 
   @doc """
   Load audio from file {.wav}.
   """
-  def load!(path) do
-    with {:ok, audio} <- load(path) do
+  def load!(path, opts \\ []) do
+    with {:ok, audio} <- load(path, opts) do
       audio
     end
   end
 
+  @doc false
+  def to_audio({:ok, {_channels, sampling, waves}}) when is_list(waves),
+    do: {:ok, Enum.map(waves, &%__MODULE__{channels: 1, sampling: sampling, wave: &1})}
+  def to_audio({:ok, {channels, sampling, wave}}),
+    do: {:ok, %__MODULE__{channels: channels, sampling: sampling, wave: wave}}
+  def to_audio(error), do: error
+
   @doc """
   Save auio to file {.wav,}.
+
+  ## Options
+
+    * `:format` - sample format of the file: `:s16`, `:s24` or `:f32` (default: :s16)
   """
-  def save(%__MODULE__{channels: channels, sampling: sampling, wave: wave}, path) do
+  def save(%__MODULE__{channels: channels, sampling: sampling, wave: wave}, path, opts \\ []) do
     saver = case Path.extname(path) do
-      ".wav" -> &NIF.wav_save/4
+      ".wav" -> &NIF.wav_save/5
     end
 
-    saver.(path, channels, sampling, wave)
+    saver.(path, channels, sampling, wave, Keyword.get(opts, :format, :s16))
+  end
+
+  @doc """
+  Decode audio from WAV image on memory. The options are same as `load/2`.
+  """
+  def decode(image, opts \\ []) when is_binary(image) do
+    NIF.wav_decode(image, Keyword.get(opts, :layout, :interleaved), opts[:offset], opts[:duration])
+    |> to_audio()
+  end
+
+  @doc """
+  Encode audio to WAV image on memory. The options are same as `save/3`.
+  """
+  def encode(%__MODULE__{channels: channels, sampling: sampling, wave: wave}, opts \\ []) do
+    NIF.wav_encode(channels, sampling, wave, Keyword.get(opts, :format, :s16))
+  end
+
+  @doc """
+  Resample %Audio{} to the sampling rate `to` by the polyphase FIR.
+  """
+  def resample(%__MODULE__{sampling: to}=audio, to), do: audio
+
+  def resample(%__MODULE__{channels: channels, sampling: from, wave: wave}=audio, to) do
+    with {:ok, {_len, resampled}} <- NIF.resample(wave, channels, from, to) do
+      %__MODULE__{audio | sampling: to, wave: resampled}
+    end
   end
 
   @doc """
@@ -83,11 +133,11 @@ defmodule Mozu.Audio do
   @doc """
   Chunk %Audio{} into overlapping segments with parameters.
   """
-  def to_frames(%__MODULE__{channels: 1, wave: wave}, hop \\ 160, window \\ 400, center \\ true) do
-    with {:ok, {len, frames}} <- Mozu.NIF.to_frames(wave, hop, window, center), do:
+  def to_frames(%__MODULE__{channels: 1, wave: wave}, hop \\ 160, window \\ 400, center \\ true, dtype \\ "<f8") do
+    with {:ok, {len, frames}} <- Mozu.NIF.to_frames(wave, hop, window, center, dtype), do:
       %{
         __struct__: Npy,
-        descr: "<f8",
+        descr: dtype,
         fortran_order: false,
         shape: {div(len, window), window},
         data: frames
@@ -102,11 +152,11 @@ defmodule Mozu.Audio do
     end
   end
 
-  def hanning(n) do
-    with {:ok, {len, han}} <- NIF.hanning(n) do
+  def hanning(n, dtype \\ "<f8") do
+    with {:ok, {len, han}} <- NIF.hanning(n, dtype) do
       %{
         __struct__: Npy,
-        descr: "<f8",
+        descr: dtype,
         fortran_order: false,
         shape: {len},
         data: han
@@ -114,11 +164,11 @@ defmodule Mozu.Audio do
     end
   end
 
-  def hamming(n) do
-    with {:ok, {len, ham}} <- NIF.hamming(n) do
+  def hamming(n, dtype \\ "<f8") do
+    with {:ok, {len, ham}} <- NIF.hamming(n, dtype) do
       %{
         __struct__: Npy,
-        descr: "<f8",
+        descr: dtype,
         fortran_order: false,
         shape: {len},
         data: ham
@@ -0,0 +1,62 @@
+defmodule Mozu.Audio.Reader do
+  alias Mozu.{Audio, NIF}
+
+  @moduledoc """
+  Streaming WAV reader.
+
+  The decoder stays open in a NIF resource, and PCM frames are read chunk
+  by chunk, so that arbitrarily long audio is processed with bounded memory.
+  """
+  defstruct ref: nil, channels: 1, sampling: 16000, length: 0
+
+  @doc """
+  Open WAV file for streaming.
+  """
+  def open(path) do
+    with {:ok, ref, {channels, sampling, length}} <- NIF.wav_open(path) do
+      {:ok, %__MODULE__{ref: ref, channels: channels, sampling: sampling, length: length}}
+    end
+  end
+
+  @doc """
+  Read next `frames` PCM frames as %Audio{}. Return :eof at the end of file.
+  """
+  def read_chunk(%__MODULE__{ref: ref, channels: channels, sampling: sampling}, frames) do
+    with {:ok, wave} <- NIF.wav_read(ref, frames) do
+      {:ok, %Audio{channels: channels, sampling: sampling, wave: wave}}
+    end
+  end
+
+  @doc """
+  Move the read position to PCM frame `frame`.
+  """
+  def seek(%__MODULE__{ref: ref}, frame) do
+    NIF.wav_seek(ref, frame)
+  end
+
+  @doc """
+  Close the reader.
+  """
+  def close(%__MODULE__{ref: ref}) do
+    NIF.wav_close(ref)
+  end
+
+  @doc """
+  Stream %Audio{} chunks of `frames` PCM frames from WAV file.
+  """
+  def stream(path, frames \\ 16000) do
+    Stream.resource(
+      fn ->
+        {:ok, reader} = open(path)
+        reader
+      end,
+      fn reader ->
+        case read_chunk(reader, frames) do
+          {:ok, audio} -> {[audio], reader}
+          :eof -> {:halt, reader}
+        end
+      end,
+      &close/1
+    )
+  end
+end
@@ -0,0 +1,58 @@
+defmodule Mozu.Audio.Writer do
+  alias Mozu.{Audio, NIF}
+
+  @moduledoc """
+  Streaming WAV writer.
+
+  The encoder stays open in a NIF resource, and %Audio{} chunks are appended
+  to the file as they are generated, so that arbitrarily long audio is saved
+  with bounded memory. The header is completed on `close/1`.
+  """
+  defstruct ref: nil, channels: 1, sampling: 16000, format: :s16
+
+  @doc """
+  Create WAV file for streaming.
+
+  ## Options
+
+    * `:format` - sample format of the file: `:s16`, `:s24` or `:f32` (default: :s16)
+  """
+  def open(path, channels, sampling, opts \\ []) do
+    format = Keyword.get(opts, :format, :s16)
+    with {:ok, ref} <- NIF.wav_writer_open(path, channels, sampling, format) do
+      {:ok, %__MODULE__{ref: ref, channels: channels, sampling: sampling, format: format}}
+    end
+  end
+
+  @doc """
+  Append %Audio{} to the file.
+  """
+  def write(%__MODULE__{ref: ref, channels: channels, sampling: sampling}, %Audio{channels: channels, sampling: sampling, wave: wave}) do
+    NIF.wav_write(ref, wave)
+  end
+
+  @doc """
+  Complete and close the file.
+  """
+  def close(%__MODULE__{ref: ref}) do
+    NIF.wav_writer_close(ref)
+  end
+
+  @doc """
+  Write the enumerable of %Audio{} chunks to WAV file. The options are same as `open/4`.
+  """
+  def stream_to(chunks, path, channels, sampling, opts \\ []) do
+    with {:ok, writer} <- open(path, channels, sampling, opts) do
+      try do
+        Enum.reduce_while(chunks, :ok, fn audio, :ok ->
+          case write(writer, audio) do
+            :ok -> {:cont, :ok}
+            error -> {:halt, error}
+          end
+        end)
+      after
+        close(writer)
+      end
+    end
+  end
+end
@@ -0,0 +1,137 @@
+defmodule Mozu.FeatureExtractor do
+  alias Mozu.NIF
+
+  @moduledoc """
+  Precomputed log-mel feature extractor.
+
+  The Hann window, the banded mel filter bank and the FFT plan are built once
+  per configuration and cached natively, so repeated requests with the same
+  parameters share one extractor.
+  """
+  defstruct ref: nil, n_fft: 400, hop: 160, n_mels: 80, sampling: 16000
+
+  @doc """
+  Get the feature extractor of the parameters. The options are same as
+  `Mozu.log_mel_spectrogram/2` except `:center`.
+  """
+  def new(opts \\ []) do
+    sampling  = Keyword.get(opts, :sampling, 16000)
+    n_fft     = Keyword.get(opts, :n_fft, 400)
+    hop       = Keyword.get(opts, :hop, 160)
+    n_mels    = Keyword.get(opts, :n_mels, 80)
+    min_freq  = Keyword.get(opts, :min_freq, 0.0)
+    max_freq  = Keyword.get(opts, :max_freq, sampling / 2)
+    mel_scale = Keyword.get(opts, :mel_scale, :slaney)
+    norm      = Keyword.get(opts, :norm, true)
+
+    with {:ok, ref} <- NIF.feature_extractor(n_fft, hop, n_mels, min_freq, max_freq, sampling, mel_scale, norm) do
+      %__MODULE__{ref: ref, n_fft: n_fft, hop: hop, n_mels: n_mels, sampling: sampling}
+    end
+  end
+
+  @doc """
+  Compute log mel spectrogram {n_mels, n_frames} of mono %Audio{}.
+  `dtype` "<f4" runs the whole chain in float32, "<f8" in float64, and
+  "<f2" in float32 with float16 output.
+
+  `normalize` selects the log convention, applied natively in the same pass:
+
+    * `:log10` - log10(max(x, 1e-10)) (default)
+    * `:whisper` - log10, clamped to max - 8 and rescaled by (x + 4) / 4
+    * `{:db, top_db}` - 10 * log10(max(x, 1e-10)) clamped to max - top_db
+      (`:db` is top_db 80.0, `{:db, nil}` no clamp)
+    * `:kaldi` - ln(max(x, float32 epsilon))
+
+  %Mozu.FrameView{} framed with the extractor's n_fft and hop is also
+  accepted; its frames are read straight from the base signal, and `center`
+  is taken from the view.
+  """
+  def log_mel_spectrogram(fe, audio, center \\ true, dtype \\ "<f8", normalize \\ :log10)
+
+  def log_mel_spectrogram(%__MODULE__{sampling: sampling} = fe,
+                          %Mozu.Audio{channels: 1, sampling: sampling, wave: wave}, center, dtype, normalize) do
+    log_mel_sub(fe, wave, center, dtype, normalize)
+  end
+
+  def log_mel_spectrogram(%__MODULE__{n_fft: n_fft, hop: hop} = fe,
+                          %Mozu.FrameView{base: base, window: n_fft, hop: hop, center: center}, _center, dtype, normalize) do
+    log_mel_sub(fe, base, center, dtype, normalize)
+  end
+
+  defp log_mel_sub(%__MODULE__{ref: ref, n_mels: n_mels}, wave, center, dtype, normalize) do
+    NIF.log_mel_spectrogram(ref, wave, center, dtype, normalize)
+    |> to_npy(n_mels, dtype)
+  end
+
+  @doc false
+  def to_npy({:ok, {len, data}}, n_rows, dtype) do
+    %{
+      __struct__: Npy,
+      descr: dtype,
+      fortran_order: false,
+      shape: {n_rows, div(len, n_rows)},
+      data: data
+    }
+  end
+  def to_npy(error, _n_rows, _dtype), do: error
+
+  @doc """
+  Compute MFCC {n_mfcc, n_frames} (float32) of mono %Audio{}: log mel
+  spectrogram, orthonormal DCT-II, liftering and deltas in one native call.
+
+  ## Options
+
+    * `:n_mfcc` - number of coefficients, up to n_mels (default: 13)
+    * `:normalize` - log convention of the mel spectrogram, see `log_mel_spectrogram/5` (default: :db)
+    * `:lifter` - cepstral liftering 1 + (lifter/2) sin(pi (k+1)/lifter), 0 for none (default: 0)
+    * `:deltas` - 1 adds the delta, 2 the delta and delta-delta rows below the coefficients;
+      the shape is then {(deltas+1)*n_mfcc, n_frames} (default: 0)
+    * `:width` - the delta regression spans +-width frames (default: 2)
+    * `:center` - reflect pad the wave by n_fft/2 on both sides (default: true)
+  """
+  def mfcc(%__MODULE__{ref: ref, sampling: sampling}, %Mozu.Audio{channels: 1, sampling: sampling, wave: wave}, opts \\ []) do
+    n_mfcc    = Keyword.get(opts, :n_mfcc, 13)
+    normalize = Keyword.get(opts, :normalize, :db)
+    lifter    = Keyword.get(opts, :lifter, 0)
+    deltas    = Keyword.get(opts, :deltas, 0)
+    width     = Keyword.get(opts, :width, 2)
+    center    = Keyword.get(opts, :center, true)
+
+    NIF.mfcc(ref, wave, center, normalize, n_mfcc, lifter, deltas, width)
+    |> to_npy((deltas + 1)*n_mfcc, "<f4")
+  end
+
+  @doc """
+  Compute log mel spectrograms {B, n_mels, n_frames} of a batch of mono
+  clips in one native call. Each clip (%Audio{} or float32 binary) is trimmed
+  or zero padded to `n_samples` samples, so that every clip has the same
+  n_frames, and the clips are computed in parallel on the native thread
+  pool (see `Mozu.Util.thread_pool/1`) into one contiguous tensor.
+
+  ## Options
+
+    * `:center` - reflect pad each clip by n_fft/2 on both sides (default: true)
+    * `:dtype` - "<f4", "<f8" or "<f2", see `log_mel_spectrogram/5` (default: "<f4")
+    * `:normalize` - log convention, see `log_mel_spectrogram/5` (default: :log10)
+  """
+  def log_mel_batch(%__MODULE__{ref: ref, n_mels: n_mels, sampling: sampling}, clips, n_samples, opts \\ []) when is_list(clips) do
+    center    = Keyword.get(opts, :center, true)
+    dtype     = Keyword.get(opts, :dtype, "<f4")
+    normalize = Keyword.get(opts, :normalize, :log10)
+
+    waves = Enum.map(clips, fn
+      %Mozu.Audio{channels: 1, sampling: ^sampling, wave: wave} -> wave
+      wave when is_binary(wave) -> wave
+    end)
+
+    with {:ok, {n_frames, data}} <- NIF.log_mel_batch(ref, waves, n_samples, center, dtype, normalize) do
+      %{
+        __struct__: Npy,
+        descr: dtype,
+        fortran_order: false,
+        shape: {length(waves), n_mels, n_frames},
+        data: data
+      }
+    end
+  end
+end
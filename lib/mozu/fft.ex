@@ -1,23 +1,45 @@
 defmodule Mozu.FFT do
 
-  alias Mozu.{Audio, NIF}
+  alias Mozu.{Audio, FrameView, NIF}
 
   @doc """
+  Real input FFT of the wave, or of every row/frame of the matrix and the
+  frame view.
+
+  ## Options
+
+    * `:power` - `:abs` or `:norm` for the power spectrum (default: nil, complex)
+    * `:dtype` - "<f4" or "<f8" of the 1D spectrum (default: "<f8")
+    * `:oneside` - 1D: only the n/2+1 one-sided bins (default: true)
+    * `:backend` - 1D: `:pocketfft` or `:native` (default: :pocketfft)
+    * `:nthreads` - 2D: the most threads of the pool to share the frames,
+      0 for the whole pool and 1 for the calling process (default: 0)
   """
   def rfft(data, opts \\ [])
   def rfft(%Audio{channels: 1, wave: wave}, opts),
     do: rfft_sub(wave, opts)
   def rfft(%{__struct__: Npy, descr: "<f4", shape: {_}, data: data}, opts),
     do: rfft_sub(data, opts)
+  def rfft(%{__struct__: Npy, descr: descr, shape: {_, n_fft}, data: data}, opts) when descr in ["<f4", "<f8"],
+    do: rfft_rows(data, descr, n_fft, n_fft, false, opts)
+  def rfft(%FrameView{base: base, window: window, hop: hop, center: center}, opts),
+    do: rfft_rows(base, "<f4", window, hop, center, opts)
 
   defp rfft_sub(data, opts) when is_binary(data) do
     power   = Keyword.get(opts, :power,  nil)
     oneside = Keyword.get(opts, :oneside, true)
+    dtype   = Keyword.get(opts, :dtype, "<f8")
+    backend = Keyword.get(opts, :backend, :pocketfft)
 
-    with {:ok, {len, rfft}} <- NIF.rfft_1D(data, power, oneside) do
+    with {:ok, {len, rfft}} <- NIF.rfft_1D(data, dtype, power, oneside, backend) do
       %{
         __struct__: Npy,
-        descr: case power do :abs -> "<f8";  :norm -> "<f8";  _else -> "<c16" end,
+        descr: case {dtype, power} do
+          {"<f4", p} when p in [:abs, :norm] -> "<f4"
+          {"<f4", _} -> "<c8"
+          {"<f8", p} when p in [:abs, :norm] -> "<f8"
+          {"<f8", _} -> "<c16"
+        end,
         fortran_order: false,
         shape: {len},
         data: rfft
@@ -25,13 +47,34 @@ defmodule Mozu.FFT do
     end
   end
 
+  defp rfft_rows(data, descr, n_fft, hop, center, opts) do
+    power    = Keyword.get(opts, :power,  nil)
+    nthreads = Keyword.get(opts, :nthreads, 0)
+
+    with {:ok, {len, rfft}} <- NIF.rfft_2D(data, descr, n_fft, hop, center, power, nthreads) do
+      n_bins = div(n_fft, 2) + 1
+      %{
+        __struct__: Npy,
+        descr: case {descr, power} do
+          {"<f4", p} when p in [:abs, :norm] -> "<f4"
+          {"<f4", _} -> "<c8"
+          {"<f8", p} when p in [:abs, :norm] -> "<f8"
+          {"<f8", _} -> "<c16"
+        end,
+        fortran_order: false,
+        shape: {div(len, n_bins), n_bins},
+        data: rfft
+      }
+    end
+  end
+
   @doc """
   """
-  def power(%{__struct__: Npy, descr: "<c16", data: data}, power) when power in [:abs, :norm] do
-    with {:ok, {len, power}} <- NIF.power(data, power) do
+  def power(%{__struct__: Npy, descr: descr, data: data}, power) when descr in ["<c8", "<c16"] and power in [:abs, :norm] do
+    with {:ok, {len, power}} <- NIF.power(data, descr, power) do
       %{
         __struct__: Npy,
-        descr: "<f8",
+        descr: if(descr == "<c8", do: "<f4", else: "<f8"),
         fortran_order: false,
         shape: {len},
         data: power
@@ -0,0 +1,62 @@
+defmodule Mozu.FFT.Plan do
+  alias Mozu.{Audio, NIF}
+
+  @moduledoc """
+  Reusable real input FFT plan of fixed size.
+
+  The plan is kept in a NIF resource, so transforms of the same size skip
+  plan lookup and allocation. A plan may be shared by any number of
+  processes: it is immutable, and every thread transforms in its own
+  scratch.
+  """
+  defstruct ref: nil, n_fft: 0, dtype: "<f8"
+
+  @doc """
+  Create FFT plan of size `n_fft` computing in `dtype` "<f4" or "<f8".
+  The plan takes input of its dtype, and the result keeps it.
+  """
+  def new(n_fft, dtype \\ "<f8") when dtype in ["<f4", "<f8"] do
+    with {:ok, ref} <- NIF.fft_plan(n_fft, dtype) do
+      %__MODULE__{ref: ref, n_fft: n_fft, dtype: dtype}
+    end
+  end
+
+  @doc """
+  Compute one-sided spectrum of every frame {n_frames, n_fft}, or of the
+  single frame {n_fft}, through the plan. %Audio{} is taken by "<f4" plans.
+
+  ## Options
+
+    * `:power` - :abs or :norm to return the power spectrum (default: nil)
+  """
+  def rfft(plan, data, opts \\ [])
+
+  def rfft(%__MODULE__{n_fft: n_fft, dtype: "<f4"} = plan, %Audio{channels: 1, wave: wave}, opts)
+      when byte_size(wave) == 4*n_fft,
+    do: rfft_sub(plan, wave, {}, opts)
+
+  def rfft(%__MODULE__{n_fft: n_fft, dtype: dtype} = plan, %{__struct__: Npy, descr: dtype, shape: {n_fft}, data: data}, opts),
+    do: rfft_sub(plan, data, {}, opts)
+
+  def rfft(%__MODULE__{n_fft: n_fft, dtype: dtype} = plan, %{__struct__: Npy, descr: dtype, shape: {n_frames, n_fft}, data: data}, opts),
+    do: rfft_sub(plan, data, {n_frames}, opts)
+
+  defp rfft_sub(%__MODULE__{ref: ref, n_fft: n_fft, dtype: dtype}, data, rows, opts) do
+    power = Keyword.get(opts, :power, nil)
+
+    with {:ok, {_len, rfft}} <- NIF.rfft_plan(ref, data, dtype, power) do
+      %{
+        __struct__: Npy,
+        descr: case {dtype, power} do
+          {"<f4", p} when p in [:abs, :norm] -> "<f4"
+          {"<f4", _} -> "<c8"
+          {"<f8", p} when p in [:abs, :norm] -> "<f8"
+          {"<f8", _} -> "<c16"
+        end,
+        fortran_order: false,
+        shape: Tuple.append(rows, div(n_fft, 2) + 1),
+        data: rfft
+      }
+    end
+  end
+end
@@ -0,0 +1,45 @@
+defmodule Mozu.FrameView do
+  alias Mozu.{Audio, NIF}
+
+  @moduledoc """
+  Strided view of overlapping frames.
+
+  The view keeps only the base signal <f4 and the framing parameters; frame
+  t is `padded[t*hop ..< t*hop + window]`. With `center` the base is reflect
+  padded by window/2 virtually, and only the boundary frames are assembled.
+  FFT and feature functions read the frames straight from the base, so the
+  overlapping frames are never materialized.
+  """
+  defstruct base: nil, n_frames: 0, window: 400, hop: 160, center: true
+
+  @doc """
+  Create the frame view of mono %Audio{}. `center` reflect pads the wave by
+  window/2 on both sides.
+  """
+  def new(%Audio{channels: 1, wave: base}, hop \\ 160, window \\ 400, center \\ true) do
+    size = div(byte_size(base), 4) + if(center, do: 2*div(window, 2), else: 0)
+    n_frames = if size >= window, do: div(size - window, hop) + 1, else: 0
+
+    %__MODULE__{base: base, n_frames: n_frames, window: window, hop: hop, center: center}
+  end
+
+  @doc """
+  Frame shape {n_frames, window}.
+  """
+  def shape(%__MODULE__{n_frames: n_frames, window: window}), do: {n_frames, window}
+
+  @doc """
+  Materialize the frames as %Npy{} {n_frames, window}.
+  """
+  def to_npy(%__MODULE__{base: base, n_frames: n_frames, window: window, hop: hop, center: center}, dtype \\ "<f8") do
+    with {:ok, {_len, frames}} <- NIF.to_frames(base, hop, window, center, dtype) do
+      %{
+        __struct__: Npy,
+        descr: dtype,
+        fortran_order: false,
+        shape: {n_frames, window},
+        data: frames
+      }
+    end
+  end
+end
@@ -0,0 +1,75 @@
+defmodule Mozu.LogMelStream do
+  alias Mozu.{Audio, FeatureExtractor, NIF}
+
+  @moduledoc """
+  Streaming log mel spectrogram for real-time audio.
+
+  The overlap tail of the frames stays in a NIF resource between chunks,
+  and the window and FFT plan are those of the feature extractor, so a push
+  computes only the frames the chunk completes. With `center: true` the
+  front is reflect padded once n_fft/2+1 samples have arrived and the rear
+  at `flush/1`: the frames of the whole stream are identical to
+  `Mozu.FeatureExtractor.log_mel_spectrogram/5` of the whole wave.
+
+  `:whisper` and `{:db, top_db}` clamp against the running max of the
+  frames so far instead of the max of the whole wave.
+  """
+  defstruct ref: nil, n_mels: 80, sampling: 16000
+
+  @doc """
+  Open the stream on the feature extractor.
+
+  ## Options
+
+    * `:center` - reflect pad n_fft/2 at both ends (default: true)
+    * `:normalize` - see `Mozu.FeatureExtractor.log_mel_spectrogram/5` (default: :log10)
+  """
+  def open(%FeatureExtractor{ref: fe, n_mels: n_mels, sampling: sampling}, opts \\ []) do
+    center    = Keyword.get(opts, :center, true)
+    normalize = Keyword.get(opts, :normalize, :log10)
+
+    with {:ok, ref} <- NIF.log_mel_stream_open(fe, center, normalize) do
+      {:ok, %__MODULE__{ref: ref, n_mels: n_mels, sampling: sampling}}
+    end
+  end
+
+  @doc """
+  Push the next chunk of mono %Audio{} (float32). Returns the log mel
+  spectrogram {n_mels, k} "<f4" of the k frames completed by the chunk.
+  """
+  def push(%__MODULE__{ref: ref, n_mels: n_mels, sampling: sampling}, %Audio{channels: 1, sampling: sampling, wave: wave}) do
+    NIF.log_mel_stream_push(ref, wave) |> to_mel(n_mels)
+  end
+
+  @doc """
+  End the stream: the frames over the rear padding.
+  """
+  def flush(%__MODULE__{ref: ref, n_mels: n_mels}) do
+    NIF.log_mel_stream_flush(ref) |> to_mel(n_mels)
+  end
+
+  defp to_mel({:ok, _} = result, n_mels), do: {:ok, FeatureExtractor.to_npy(result, n_mels, "<f4")}
+  defp to_mel(error, _n_mels), do: error
+
+  @doc """
+  Log mel spectrograms of the stream of %Audio{} chunks, e.g. from
+  `Mozu.Audio.Reader.stream/2`. The options are same as `open/2`.
+  """
+  def stream(chunks, fe, opts \\ []) do
+    Stream.transform(chunks,
+      fn ->
+        {:ok, stream} = open(fe, opts)
+        stream
+      end,
+      fn audio, stream ->
+        {:ok, mel} = push(stream, audio)
+        {[mel], stream}
+      end,
+      fn stream ->
+        {:ok, tail} = flush(stream)
+        {[tail], stream}
+      end,
+      fn _ -> :ok end
+    )
+  end
+end
@@ -0,0 +1,52 @@
+defmodule Mozu.MelBank do
+  alias Mozu.NIF
+
+  @moduledoc """
+  Mel filter bank in banded form.
+
+  Each triangular filter keeps only its non-zero band of frequency bins,
+  so applying it to a power spectrogram costs O(nnz).
+  """
+  defstruct ref: nil, n_freq_bins: 0, n_mel_filters: 0
+
+  @doc """
+  Create banded mel filter bank. The parameters are same as `Mozu.mel_filter_bank/8`.
+  """
+  def new(n_freq_bins, n_mel_filters, min_freq, max_freq, sampling_rate, mel_scale \\ :htk, norm \\ false, triangularize_in_mel_space \\ false) do
+    with {:ok, ref} <- NIF.mel_bank_create(n_freq_bins, n_mel_filters, min_freq, max_freq, sampling_rate, mel_scale, norm, triangularize_in_mel_space) do
+      %__MODULE__{ref: ref, n_freq_bins: n_freq_bins, n_mel_filters: n_mel_filters}
+    end
+  end
+
+  @doc """
+  Export dense matrix {n_freq_bins, n_mel_filters}.
+  """
+  def to_dense(%__MODULE__{ref: ref, n_freq_bins: n_freq_bins, n_mel_filters: n_mel_filters}) do
+    with {:ok, {_len, data}} <- NIF.mel_bank_to_dense(ref) do
+      %{
+        __struct__: Npy,
+        descr: "<f8",
+        fortran_order: false,
+        shape: {n_freq_bins, n_mel_filters},
+        data: data
+      }
+    end
+  end
+
+  @doc """
+  Apply mel filter bank to power spectrogram {n_frames, n_freq_bins}.
+  Return mel spectrogram {n_mel_filters, n_frames}.
+  """
+  def apply_to(%__MODULE__{ref: ref, n_freq_bins: n_freq_bins, n_mel_filters: n_mel_filters},
+               %{__struct__: Npy, descr: descr, shape: {n_frames, n_freq_bins}, data: data}) when descr in ["<f4", "<f8"] do
+    with {:ok, {_len, mel}} <- NIF.mel_apply(ref, data, descr) do
+      %{
+        __struct__: Npy,
+        descr: descr,
+        fortran_order: false,
+        shape: {n_mel_filters, n_frames},
+        data: mel
+      }
+    end
+  end
+end
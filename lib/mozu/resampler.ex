@@ -0,0 +1,60 @@
+defmodule Mozu.Resampler do
+  alias Mozu.{Audio, NIF}
+
+  @moduledoc """
+  Streaming resampler.
+
+  The filter history stays in a NIF resource between chunks, so a stream
+  resampled chunk by chunk is identical to `Mozu.Audio.resample/2` of the
+  whole wave. Filter tables are cached per rate ratio and shared.
+  """
+  defstruct ref: nil, channels: 1, from: 16000, to: 16000
+
+  @doc """
+  Open resampler of `channels` interleaved channels from `from` Hz to `to` Hz.
+  """
+  def open(channels, from, to) do
+    with {:ok, ref} <- NIF.resampler_open(channels, from, to) do
+      {:ok, %__MODULE__{ref: ref, channels: channels, from: from, to: to}}
+    end
+  end
+
+  @doc """
+  Resample the next chunk %Audio{}.
+  """
+  def push(%__MODULE__{ref: ref, channels: channels, from: from, to: to}, %Audio{channels: channels, sampling: from, wave: wave}) do
+    with {:ok, {_len, resampled}} <- NIF.resampler_push(ref, wave) do
+      {:ok, %Audio{channels: channels, sampling: to, wave: resampled}}
+    end
+  end
+
+  @doc """
+  Drain the tail of the stream.
+  """
+  def flush(%__MODULE__{ref: ref, channels: channels, to: to}) do
+    with {:ok, {_len, resampled}} <- NIF.resampler_flush(ref) do
+      {:ok, %Audio{channels: channels, sampling: to, wave: resampled}}
+    end
+  end
+
+  @doc """
+  Resample the stream of %Audio{} chunks, e.g. from `Mozu.Audio.Reader.stream/2`.
+  """
+  def stream(chunks, to) do
+    Stream.transform(chunks,
+      fn -> nil end,
+      fn %Audio{channels: channels, sampling: from}=audio, resampler ->
+        {:ok, resampler} = if resampler, do: {:ok, resampler}, else: open(channels, from, to)
+        {:ok, resampled} = push(resampler, audio)
+        {[resampled], resampler}
+      end,
+      fn
+        nil -> {[], nil}
+        resampler ->
+          {:ok, tail} = flush(resampler)
+          {[tail], resampler}
+      end,
+      fn _ -> :ok end
+    )
+  end
+end
@@ -2,17 +2,18 @@ defmodule Mozu.Util do
   alias Mozu.NIF
 
   @doc """
+  Convert %Npy{} to the dtype `astype`.
+
+  The real dtypes "<f4", "<f8", "<f2", "bf16", "<i4", "<u4", "<i2" and "<u1"
+  convert to each other, and "<c8" to/from "<c16". The conversion to any
+  integer dtype rounds to nearest even and saturates to its range; NaN
+  becomes 0.
   """
   def astype(%{__struct__: Npy, descr: type}=npy, astype) when type == astype,
     do: npy
 
   def astype(%{__struct__: Npy, descr: type, data: data}=npy, astype) do
-    {:ok, {_len, typed}} = case type do
-      "<f4" -> NIF.f4_astype(data, astype)
-      "<f8" -> NIF.f8_astype(data, astype)
-      "<c8" -> NIF.c8_astype(data, astype)
-      "<c16" -> NIF.c16_astype(data, astype)
-    end
+    {:ok, {_len, typed}} = NIF.astype(data, type, astype)
 
     %{npy | descr: astype, data: typed}
   end
@@ -22,8 +23,8 @@ defmodule Mozu.Util do
 
   ### Examples
 
-      iex> linspace(2.0, 3.0, 5)
-      %Npy{shape: {5}, <<>>}  # 2.0, 2.2, 2.4, 2.6, 2.8, 3.0}
+      Mozu.Util.linspace(2.0, 3.0, 5)
+      #=> %Npy{descr: "<f8", shape: {5}, data: <<...>>}  # 2.0, 2.25, 2.5, 2.75, 3.0
 
   """
   def linspace(start, stop, num, endpoint \\ true) do
@@ -36,4 +37,31 @@ defmodule Mozu.Util do
         data: data
       }
   end
+
+  @doc """
+  SIMD kernels of the elementwise operations: `{:ok, current, supported}`.
+  """
+  def simd_info(), do: NIF.simd_info()
+
+  @doc """
+  Switch the SIMD kernels to `:scalar`, `:avx2`, `:avx512`, `:neon` or the best one (`:auto`).
+  It is meant for benchmarks and troubleshooting.
+  """
+  def simd_backend(name), do: NIF.simd_backend(name)
+
+  @doc """
+  Resize the native thread pool shared by the STFT, mel and conversion
+  kernels to `size` threads, the calling scheduler included; 0 is the
+  number of dirty CPU schedulers and 1 keeps every kernel on the calling
+  scheduler. The callers and the async runners count against the size, so
+  the kernels never run on more threads than it at once.
+  The size at load is taken from `config :mozu, threads: size`.
+  Returns `{:ok, size}`.
+  """
+  def thread_pool(size), do: NIF.thread_pool(size)
+
+  @doc """
+  Size of the native thread pool: `{:ok, size}`.
+  """
+  def thread_pool_info(), do: NIF.thread_pool_info()
 end
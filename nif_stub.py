@@ -43,7 +43,7 @@ class NifStub:
                '  @on_load :load_nif\n'
                '  def load_nif do\n'
                '    nif_file = Application.app_dir({app}, "priv/{nif}")\n'
-               '    :erlang.load_nif(nif_file, 0)\n'
+               '    :erlang.load_nif(nif_file, {{Application.get_env({app}, :threads, 0), :erlang.system_info(:dirty_cpu_schedulers_online)}})\n'
                '  end\n'
                '\n'
                '  # stub implementations for NIFs (fallback)\n'
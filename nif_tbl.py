@@ -20,6 +20,12 @@ import re
 # Dependencies: 
 ################################################################################
 class NifTbl:
+    DIRTY_FLAGS = {
+        None:         '0',
+        '_DIRTY_CPU': 'ERL_NIF_DIRTY_JOB_CPU_BOUND',
+        '_DIRTY_IO':  'ERL_NIF_DIRTY_JOB_IO_BOUND'
+    }
+
     def __init__(self, prefix="", namespace="", col=40):
         self.prefix = prefix
         self.ns     = namespace
@@ -28,36 +34,51 @@ class NifTbl:
 
     def parse(self, file):
         name  = None
+        valid = {}      # arity checked in DECL_VALIDATE(name) of the wrapper
         for line in file:
-            match = re.search(r'\bDECL_NIF\s*\((.*)\)', line)
+            match = re.search(r'\bDECL_VALIDATE\s*\((.*)\)', line)
+            if match:
+                dirty = None
+                name  = match.group(1)
+                continue
+
+            match = re.search(r'\bDECL_NIF(_DIRTY_CPU|_DIRTY_IO)?\s*\((.*)\)', line)
             if match:
-                name = match.group(1)
+                dirty = self.DIRTY_FLAGS[match.group(1)]
+                name  = match.group(2)
+                if name in valid:
+                    self.func.append((name, valid.pop(name), dirty))
+                    name = None
                 continue
 
             match = re.search(r'ality\s*!=\s*(\d+)', line)
             if match and name != None:
                 ality = int(match.group(1))
-                self.func.append((name, ality))
+                if dirty == None:
+                    valid[name] = ality
+                else:
+                    self.func.append((name, ality, dirty))
                 name = None
                 continue
 
     def mk_niftbl(self, output):
-        for name, _ in self.func:
+        for name, _, _ in self.func:
             print('_DECL_NIF({cxx_name});'.format(cxx_name=name), file=output)
 
         print("\nstatic ErlNifFunc nif_funcs[] = {", file=output)
         print("//  {erl_function_name, erl_function_arity, c_function, dirty_flags}", file=output)
-        for name, ality in self.func:
+        for name, ality, dirty in self.func:
             erl_name = self.prefix + name
             cxx_name = self.ns + name
             print(cxx_name)
-            print('{{"{erl_name}",{pad:{loc1}}{ality:2d},  {cxx_name},{pad:{loc2}}0}},'
+            print('{{"{erl_name}",{pad:{loc1}}{ality:2d},  {cxx_name},{pad:{loc2}}{dirty}}},'
                    .format(
                        erl_name=erl_name,
                        loc1=self.col-len(erl_name)-3,
                        ality=ality,
                        cxx_name=cxx_name,
                        loc2=self.col-len(cxx_name)-1,
+                       dirty=dirty,
                        pad=''),
                    file=output)
         print("};", file=output)
@@ -0,0 +1,365 @@
+/***  File Header  ************************************************************/
+/**
+* async_job.cc
+*
+* Elixir/Erlang Port ext. of Post-processing for DNN.
+* @author   Shozo Fukuda
+* @date     create 2026-10-18 00:41:55
+* System    Windows10, WSL2/Ubuntu 20.04.2<br>
+*
+**/
+/**************************************************************************{{{*/
+
+#include "my_erl_nif.h"
+#include <algorithm>
+#include <cstring>
+#include "async_job.h"
+#include "thread_pool.h"
+
+// the NIFs that may run as a job: stateless, so no resource is locked by a runner.
+DECL_VALIDATE(wav_load);
+DECL_VALIDATE(wav_decode);
+DECL_VALIDATE(resample);
+DECL_VALIDATE(log_mel_spectrogram);
+DECL_VALIDATE(log_mel_batch);
+DECL_VALIDATE(mfcc);
+DECL_VALIDATE(rfft_2D);
+DECL_VALIDATE(power);
+DECL_VALIDATE(mel_apply);
+DECL_VALIDATE(astype);
+
+static const struct {
+    const char*        name;
+    AsyncJob::Validate validate;
+} async_nifs[] = {
+    {"wav_load",            wav_load_validate           },
+    {"wav_decode",          wav_decode_validate         },
+    {"resample",            resample_validate           },
+    {"log_mel_spectrogram", log_mel_spectrogram_validate},
+    {"log_mel_batch",       log_mel_batch_validate      },
+    {"mfcc",                mfcc_validate               },
+    {"rfft_2D",             rfft_2D_validate            },
+    {"power",               power_validate              },
+    {"mel_apply",           mel_apply_validate          },
+    {"astype",              astype_validate             },
+};
+
+static JobQueue* s_jobs = nullptr;
+
+/***  Module Header  ******************************************************}}}*/
+/**
+* job queue
+* @par DESCRIPTION
+*   Start the runners. At the end, the queued jobs are answered with
+*   {:error, :cancelled} and the running ones are waited for.
+**/
+/**************************************************************************{{{*/
+JobQueue::JobQueue(unsigned runners, size_t capacity)
+: m_n_runners(0), m_target(0), m_capacity(capacity), m_stop(false)
+{
+    configure(runners, capacity);
+}
+
+JobQueue::~JobQueue()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+
+        for (AsyncJob* job : m_queue) {
+            reply(job, enif_make_error(job->m_env, enif_make_atom(job->m_env, "cancelled")));
+            delete job;
+        }
+        m_queue.clear();
+    }
+    m_wake.notify_all();
+
+    for (auto& thread : m_threads) {
+        thread.join();
+    }
+}
+
+void JobQueue::configure(unsigned runners, size_t capacity)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // the runners gone have left the lock for good, so they are joined at once.
+    for (std::thread::id id : m_exited) {
+        auto exited = std::find_if(m_threads.begin(), m_threads.end(), [&](const std::thread& thread) {
+            return thread.get_id() == id;
+        });
+        exited->join();
+        m_threads.erase(exited);
+    }
+    m_exited.clear();
+
+    m_capacity = capacity;
+    m_target   = std::max(runners, 1u);
+
+    // the surplus runners leave after their current job.
+    while (m_n_runners < m_target) {
+        m_threads.emplace_back(&JobQueue::runner, this);
+        m_n_runners++;
+    }
+    m_wake.notify_all();
+}
+
+/***  Module Header  ******************************************************}}}*/
+/**
+* submit/cancel
+* @par DESCRIPTION
+*   submit takes the ownership of the job unless the queue is full.
+*   cancel finds the job by its reference among the queued and the running.
+*
+* @retval true if done
+**/
+/**************************************************************************{{{*/
+bool JobQueue::submit(AsyncJob* job)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_stop || m_queue.size() >= m_capacity) {
+            return false;
+        }
+        m_queue.push_back(job);
+    }
+    m_wake.notify_one();
+
+    return true;
+}
+
+bool JobQueue::cancel(ERL_NIF_TERM ref)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto queued = std::find_if(m_queue.begin(), m_queue.end(), [&](AsyncJob* job) {
+        return enif_is_identical(job->m_ref, ref);
+    });
+    if (queued != m_queue.end()) {
+        delete *queued;
+        m_queue.erase(queued);
+        return true;
+    }
+
+    for (AsyncJob* job : m_running) {
+        if (!job->m_cancelled && enif_is_identical(job->m_ref, ref)) {
+            job->m_cancelled = true;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void JobQueue::info(size_t* queued, size_t* running, unsigned* runners, size_t* capacity)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    *queued   = m_queue.size();
+    *running  = m_running.size();
+    *runners  = m_target;
+    *capacity = m_capacity;
+}
+
+/***  Module Header  ******************************************************}}}*/
+/**
+* runner
+* @par DESCRIPTION
+*   Take the oldest job, run its compute step in the job's env outside the
+*   lock, and send the result unless the job was cancelled meanwhile. The
+*   runner is counted busy on the thread pool while it computes.
+**/
+/**************************************************************************{{{*/
+void JobQueue::runner()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    for (;;) {
+        m_wake.wait(lock, [&]{ return m_stop || m_n_runners > m_target || !m_queue.empty(); });
+        if (m_stop || m_n_runners > m_target) {
+            m_n_runners--;
+            m_exited.push_back(std::this_thread::get_id());
+            return;
+        }
+
+        AsyncJob* job = m_queue.front();
+        m_queue.pop_front();
+        m_running.push_back(job);
+        lock.unlock();
+
+        ERL_NIF_TERM result;
+        {
+            ThreadPool::Seat seat;
+            result = job->m_compute(job->m_env);
+        }
+
+        lock.lock();
+        m_running.erase(std::find(m_running.begin(), m_running.end(), job));
+        if (!job->m_cancelled) {
+            reply(job, result);
+        }
+        delete job;
+    }
+}
+
+void JobQueue::reply(AsyncJob* job, ERL_NIF_TERM result)
+{
+    ErlNifEnv* env = job->m_env;
+    enif_send(NULL, &job->m_pid, env, enif_make_tuple3(env, enif_make_atom(env, "mozu_result"), job->m_ref, result));
+}
+
+/***  Module Header  ******************************************************}}}*/
+/**
+* process-wide queue
+* @par DESCRIPTION
+*   Created at NIF load and deleted at unload.
+**/
+/**************************************************************************{{{*/
+void JobQueue::start()
+{
+    if (s_jobs == nullptr) {
+        s_jobs = new JobQueue(ASYNC_RUNNERS, ASYNC_CAPACITY);
+    }
+}
+
+void JobQueue::stop()
+{
+    delete s_jobs;
+    s_jobs = nullptr;
+}
+
+JobQueue* JobQueue::get()
+{
+    return s_jobs;
+}
+
+/***  Module Header  ******************************************************}}}*/
+/**
+* submit asynchronous job
+* @par DESCRIPTION
+*   Validate the arguments of the NIF `name` here, queue its compute step,
+*   and return the reference at once. The result comes to the caller as
+*   {:mozu_result, ref, result}. A full queue returns {:error, :busy}.
+*
+* @retval {:ok, ref}
+**/
+/**************************************************************************{{{*/
+DECL_NIF(async_submit) {
+    char name[32];
+    unsigned n_args;
+    ErlNifPid pid;
+
+    if (ality != 2
+    || !enif_get_atom(env, term[0], name, sizeof(name), ERL_NIF_LATIN1)
+    || !enif_get_list_length(env, term[1], &n_args)
+    || !enif_self(env, &pid)
+    || JobQueue::get() == nullptr) {
+        return enif_make_badarg(env);
+    }
+
+    auto entry = std::find_if(std::begin(async_nifs), std::end(async_nifs), [&](const decltype(async_nifs[0]) item) {
+        return std::strcmp(item.name, name) == 0;
+    });
+    if (entry == std::end(async_nifs)) {
+        return enif_make_badarg(env);
+    }
+
+    AsyncJob* job = new AsyncJob(pid);
+
+    // binaries are shared by the copy, not duplicated.
+    ERL_NIF_TERM list = term[1], head;
+    while (enif_get_list_cell(env, list, &head, &list)) {
+        job->m_args.push_back(enif_make_copy(job->m_env, head));
+    }
+
+    // the compute step refers to the copies, which live as long as the job.
+    double work;
+    if (!entry->validate(job->m_env, int(job->m_args.size()), job->m_args.data(), job->m_compute, &work)) {
+        delete job;
+        return enif_make_badarg(env);
+    }
+    ERL_NIF_TERM ref = enif_make_ref(env);
+    job->m_ref = enif_make_copy(job->m_env, ref);
+
+    if (!JobQueue::get()->submit(job)) {
+        delete job;
+        return enif_make_error(env, enif_make_atom(env, "busy"));
+    }
+
+    return enif_make_ok(env, ref);
+}
+
+/***  Module Header  ******************************************************}}}*/
+/**
+* cancel asynchronous job
+* @par DESCRIPTION
+*   Drop the job from the queue, or discard its result if it is running.
+*   After :ok no result message of the job is sent; {:error, :not_found}
+*   means the job is unknown or its result has been sent already.
+*
+* @retval :ok
+**/
+/**************************************************************************{{{*/
+DECL_NIF(async_cancel) {
+    if (ality != 1
+    || !enif_is_ref(env, term[0])
+    || JobQueue::get() == nullptr) {
+        return enif_make_badarg(env);
+    }
+
+    return JobQueue::get()->cancel(term[0]) ? enif_make_ok(env)
+                                            : enif_make_error(env, enif_make_atom(env, "not_found"));
+}
+
+/***  Module Header  ******************************************************}}}*/
+/**
+* configure asynchronous jobs
+* @par DESCRIPTION
+*   Set the number of runner threads and the queue capacity.
+*
+* @retval :ok
+**/
+/**************************************************************************{{{*/
+DECL_NIF(async_config) {
+    unsigned runners;
+    unsigned capacity;
+
+    if (ality != 2
+    || !enif_get_uint(env, term[0], &runners)
+    || !enif_get_uint(env, term[1], &capacity)
+    || runners == 0
+    || JobQueue::get() == nullptr) {
+        return enif_make_badarg(env);
+    }
+
+    JobQueue::get()->configure(runners, capacity);
+
+    return enif_make_ok(env);
+}
+
+/***  Module Header  ******************************************************}}}*/
+/**
+* asynchronous jobs info
+* @par DESCRIPTION
+*   The number of the queued and the running jobs, of the runner threads
+*   and the queue capacity.
+*
+* @retval {:ok, {queued, running, runners, capacity}}
+**/
+/**************************************************************************{{{*/
+DECL_NIF(async_info) {
+    size_t queued, running, capacity;
+    unsigned runners;
+
+    if (ality != 0
+    || JobQueue::get() == nullptr) {
+        return enif_make_badarg(env);
+    }
+
+    JobQueue::get()->info(&queued, &running, &runners, &capacity);
+
+    return enif_make_ok(env, enif_make_tuple4(env,
+        enif_make_uint64(env, queued), enif_make_uint64(env, running), enif_make_uint(env, runners), enif_make_uint64(env, capacity)));
+}
+
+/*** async_job.cc ********************************************************}}}*/
@@ -0,0 +1,121 @@
+/***  File Header  ************************************************************/
+/**
+* async_job.h
+*
+* Elixir/Erlang Port ext. of Post-processing for DNN.
+* @author   Shozo Fukuda
+* @date     create 2026-10-18 00:41:55
+* System    Windows10, WSL2/Ubuntu 20.04.2<br>
+*
+**/
+/**************************************************************************{{{*/
+#ifndef _ASYNC_JOB_H
+#define _ASYNC_JOB_H
+
+#include "my_erl_nif.h"
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+#define ASYNC_RUNNERS   2
+#define ASYNC_CAPACITY  64
+
+/***  Module Header  ******************************************************}}}*/
+/**
+* validate/compute steps of NIF
+* @par DESCRIPTION
+*   A NIF that may run as a job is split in two steps. The validate step
+*   decodes and checks the arguments, and binds the compute step to them;
+*   work is the estimate for YIELD_TO_DIRTY_CPU. Neither step raises nor
+*   schedules: the compute step reports its failures as {:error, reason},
+*   so both fit the job's env on a runner as well as the NIF call.
+*   The arguments must outlive the compute step.
+*
+* @retval true if the arguments are valid
+**/
+/**************************************************************************{{{*/
+typedef std::function<ERL_NIF_TERM(ErlNifEnv* env)> AsyncCompute;
+
+#define DECL_VALIDATE(name) \
+bool name##_validate(ErlNifEnv* env, int ality, const ERL_NIF_TERM term[], AsyncCompute& compute, double* work)
+
+/***  Class Header  *******************************************************}}}*/
+/**
+* asynchronous job
+* @par description
+*   the compute step of a NIF off the schedulers. the arguments, the job
+*   reference and the result live in the job's own process independent env,
+*   which is sent to the submitter as {:mozu_result, ref, result}.
+**/
+/**************************************************************************{{{*/
+struct AsyncJob {
+    typedef bool (*Validate)(ErlNifEnv* env, int ality, const ERL_NIF_TERM term[], AsyncCompute& compute, double* work);
+
+    explicit AsyncJob(const ErlNifPid& pid)
+    : m_pid(pid), m_env(enif_alloc_env()), m_cancelled(false) {}
+
+    ~AsyncJob() {
+        enif_free_env(m_env);
+    }
+
+    ErlNifPid                 m_pid;
+    AsyncCompute              m_compute;
+    ErlNifEnv*                m_env;
+    ERL_NIF_TERM              m_ref;
+    std::vector<ERL_NIF_TERM> m_args;
+    bool                      m_cancelled;
+};
+
+/***  Class Header  *******************************************************}}}*/
+/**
+* bounded job queue
+* @par description
+*   FIFO of at most capacity jobs drained by the runner threads. a full
+*   queue refuses the job, which is the backpressure to the submitter.
+*   the runners call the compute step of the NIF, so its frame blocks
+*   still go to the thread pool. the threads of the runners gone by a
+*   smaller configuration are joined at the next one.
+*   a job is cancelled by dropping it from the queue, or by discarding the
+*   result if it is running already: once cancel() returns true, no message
+*   is sent for the job.
+**/
+/**************************************************************************{{{*/
+class JobQueue {
+public:
+    JobQueue(unsigned runners, size_t capacity);
+    ~JobQueue();
+
+    void configure(unsigned runners, size_t capacity);
+
+    // false if the queue is full (the job is not taken).
+    bool submit(AsyncJob* job);
+
+    bool cancel(ERL_NIF_TERM ref);
+
+    void info(size_t* queued, size_t* running, unsigned* runners, size_t* capacity);
+
+    static void start();
+    static void stop();
+    static JobQueue* get();
+
+protected:
+    void runner();
+    void reply(AsyncJob* job, ERL_NIF_TERM result);
+
+    std::mutex                   m_mutex;
+    std::condition_variable      m_wake;
+    std::deque<AsyncJob*>        m_queue;
+    std::vector<AsyncJob*>       m_running;
+    std::vector<std::thread>     m_threads;
+    std::vector<std::thread::id> m_exited;      // runners gone, to be joined
+    unsigned                     m_n_runners;   // alive runners
+    unsigned                     m_target;      // runners wanted
+    size_t                       m_capacity;
+    bool                         m_stop;
+};
+
+#endif
+/*** async_job.h *********************************************************}}}*/
@@ -18,18 +18,233 @@
 #define DR_WAV_IMPLEMENTATION
 #include "dr_wav.h"
 
+#include "audio.h"
 #include "npy_utils.h"
+#include "async_job.h"
+
+/***  Module Header  ******************************************************}}}*/
+/**
+* Decode range of PCM frames
+* @par DESCRIPTION
+*   Read the PCM frames [offset, offset+duration) of the opened drwav as f32
+*   and uninit it. offset/duration are frames or seconds (nil: the start/
+*   the rest); the decoder seeks to offset, so only the range is read and
+*   allocated. A channel beyond the stream results in
+*   {:error, :invalid_channel}, an undecodable stream in
+*   {:error, :invalid_wav}. Except for :interleaved, the frames are read
+*   through a small stack buffer and downmixed/selected/split in the same
+*   pass, so the whole interleaved PCM is never allocated.
+*
+* @retval {:ok, {channels, sample_rate, binary | [binary]}}
+**/
+/**************************************************************************{{{*/
+#define WAV_CHUNK_SAMPLES 4096
+
+static ERL_NIF_TERM _wav_read_all(ErlNifEnv* env, drwav& wav, const WavLayout& layout, const WavFrames& offset_frames, const WavFrames& duration_frames)
+{
+    const uint16_t channels    = wav.channels;
+    const uint32_t sample_rate = wav.sampleRate;
+    const uint64_t total       = wav.totalPCMFrameCount;
+
+    if (channels > WAV_CHUNK_SAMPLES) {
+        drwav_uninit(&wav);
+        return enif_make_error(env, enif_make_atom(env, "invalid_wav"));
+    }
+    if (layout.mode == WAV_CHANNEL && layout.channel >= channels) {
+        drwav_uninit(&wav);
+        return enif_make_error(env, enif_make_atom(env, "invalid_channel"));
+    }
+
+    // clip the range to the stream.
+    const uint64_t offset   = std::min(offset_frames.resolve(sample_rate, 0), total);
+    const uint64_t n_frames = std::min(duration_frames.resolve(sample_rate, total), total - offset);
+
+    if (offset > 0 && !drwav_seek_to_pcm_frame(&wav, offset)) {
+        drwav_uninit(&wav);
+        return enif_make_error(env);
+    }
+
+    // output planes: one per channel for :split, one otherwise.
+    const size_t n_planes = (layout.mode == WAV_SPLIT) ? channels : 1;
+    const size_t width    = (layout.mode == WAV_INTERLEAVED) ? channels : 1;
+
+    std::vector<ErlNifBinary> pcm(n_planes);
+    for (size_t i = 0; i < n_planes; i++) {
+        if (!enif_alloc_binary(n_frames * width * sizeof(float), &pcm[i])) {
+            while (i > 0) {
+                enif_release_binary(&pcm[--i]);
+            }
+            drwav_uninit(&wav);
+            return enif_make_error(env);
+        }
+    }
+
+    uint64_t n_read = 0;
+    if (layout.mode == WAV_INTERLEAVED) {
+        n_read = drwav_read_pcm_frames_f32(&wav, n_frames, (float*)pcm[0].data);
+    }
+    else {
+        float chunk[WAV_CHUNK_SAMPLES];
+        const uint64_t chunk_frames = WAV_CHUNK_SAMPLES / channels;
+
+        while (n_read < n_frames) {
+            uint64_t got = drwav_read_pcm_frames_f32(&wav, std::min(chunk_frames, n_frames - n_read), chunk);
+            if (got == 0) {
+                break;
+            }
+
+            const float* src = chunk;
+            for (uint64_t i = 0; i < got; i++, n_read++, src += channels) {
+                switch (layout.mode) {
+                case WAV_MONO:
+                    {
+                        float sum = 0.0f;
+                        for (int c = 0; c < channels; c++) {
+                            sum += src[c];
+                        }
+                        ((float*)pcm[0].data)[n_read] = sum/channels;
+                    }
+                    break;
+                case WAV_CHANNEL:
+                    ((float*)pcm[0].data)[n_read] = src[layout.channel];
+                    break;
+                case WAV_SPLIT:
+                    for (int c = 0; c < channels; c++) {
+                        ((float*)pcm[c].data)[n_read] = src[c];
+                    }
+                    break;
+                }
+            }
+        }
+    }
+
+    drwav_uninit(&wav);
+
+    // a truncated file yields fewer frames than the header says.
+    std::vector<ERL_NIF_TERM> planes(n_planes);
+    for (size_t i = 0; i < n_planes; i++) {
+        if (n_read < n_frames) {
+            enif_realloc_binary(&pcm[i], n_read * width * sizeof(float));
+        }
+        planes[i] = enif_make_binary(env, &pcm[i]);
+    }
+
+    return enif_make_ok(env,
+             enif_make_tuple3(env,
+                enif_make_uint(env, (layout.mode == WAV_MONO || layout.mode == WAV_CHANNEL) ? 1 : channels),
+                enif_make_uint(env, sample_rate),
+                (layout.mode == WAV_SPLIT) ? enif_make_list_from_array(env, planes.data(), n_planes) : planes[0]));
+}
 
 /***  Module Header  ******************************************************}}}*/
 /**
 * Load WAV file
 * @par DESCRIPTION
-*   Load audio data from specific WAV file.
+*   Load audio data from specific WAV file in the layout. Only the range
+*   of offset/duration is read. A file not to be opened as WAV results in
+*   {:error, :invalid_wav}.
 *
 * @retval binary
 **/
 /**************************************************************************{{{*/
-DECL_NIF(wav_load) {
+DECL_VALIDATE(wav_load) {
+    std::string fname;
+    WavLayout layout;
+    WavFrames offset;
+    WavFrames duration;
+
+    if (ality != 4
+    || !enif_get_str(env, term[0], &fname)
+    || !enif_get_wav_layout(env, term[1], &layout)
+    || !enif_get_wav_frames(env, term[2], &offset)
+    || !enif_get_wav_frames(env, term[3], &duration)) {
+        return false;
+    }
+
+    *work = 0.0;
+
+    compute = [=](ErlNifEnv* env) {
+        drwav wav;
+        if (!drwav_init_file(&wav, fname.c_str(), NULL)) {
+            return enif_make_error(env, enif_make_atom(env, "invalid_wav"));
+        }
+        return _wav_read_all(env, wav, layout, offset, duration);
+    };
+
+    return true;
+}
+
+DECL_NIF_DIRTY_IO(wav_load) {
+    AsyncCompute compute;
+    double work;
+
+    if (!wav_load_validate(env, ality, term, compute, &work)) {
+        return enif_make_badarg(env);
+    }
+
+    return compute(env);
+}
+
+/***  Module Header  ******************************************************}}}*/
+/**
+* Decode WAV binary
+* @par DESCRIPTION
+*   Decode audio data from WAV image on memory. The header is parsed in
+*   place; the payload is not copied before decoding. Only the range of
+*   offset/duration is decoded. An image not to be parsed as WAV results
+*   in {:error, :invalid_wav}.
+*
+* @retval binary
+**/
+/**************************************************************************{{{*/
+DECL_VALIDATE(wav_decode) {
+    ErlNifBinary image;
+    WavLayout layout;
+    WavFrames offset;
+    WavFrames duration;
+
+    if (ality != 4
+    || !enif_inspect_binary(env, term[0], &image)
+    || !enif_get_wav_layout(env, term[1], &layout)
+    || !enif_get_wav_frames(env, term[2], &offset)
+    || !enif_get_wav_frames(env, term[3], &duration)) {
+        return false;
+    }
+
+    *work = image.size;
+
+    compute = [=](ErlNifEnv* env) {
+        drwav wav;
+        if (!drwav_init_memory(&wav, image.data, image.size, NULL)) {
+            return enif_make_error(env, enif_make_atom(env, "invalid_wav"));
+        }
+        return _wav_read_all(env, wav, layout, offset, duration);
+    };
+
+    return true;
+}
+
+DECL_NIF_DIRTY_CPU(wav_decode) {
+    AsyncCompute compute;
+    double work;
+
+    if (!wav_decode_validate(env, ality, term, compute, &work)) {
+        return enif_make_badarg(env);
+    }
+
+    return compute(env);
+}
+
+/***  Module Header  ******************************************************}}}*/
+/**
+* Open WAV file for streaming
+* @par DESCRIPTION
+*   Open the WAV file and keep its decoder in the resource.
+*
+* @retval {:ok, reader, {channels, sample_rate, total_frames}}
+**/
+/**************************************************************************{{{*/
+DECL_NIF_DIRTY_IO(wav_open) {
     std::string fname;
 
     if (ality != 1
@@ -37,145 +252,465 @@ DECL_NIF(wav_load) {
         return enif_make_badarg(env);
     }
 
-    drwav wav;
-    if (!drwav_init_file(&wav, fname.c_str(), NULL)) {
+    WavReader* reader = new WavReader();
+    if (!reader->open(fname.c_str())) {
+        delete reader;
+        return enif_make_badarg(env);
+    }
+
+    return Resource<WavReader>::make_resource(env, reader,
+             enif_make_tuple3(env,
+                enif_make_uint(env, reader->m_wav.channels),
+                enif_make_uint(env, reader->m_wav.sampleRate),
+                enif_make_uint64(env, reader->m_wav.totalPCMFrameCount)));
+}
+
+/***  Module Header  ******************************************************}}}*/
+/**
+* Read chunk from WAV file
+* @par DESCRIPTION
+*   Read next PCM frames up to the specified count.
+*
+* @retval {:ok, binary} or :eof
+**/
+/**************************************************************************{{{*/
+DECL_NIF_DIRTY_IO(wav_read) {
+    WavReader* reader;
+    ErlNifUInt64 frames;
+
+    if (ality != 2
+    || !Resource<WavReader>::get_item(env, term[0], &reader)
+    || !enif_get_uint64(env, term[1], &frames)) {
         return enif_make_badarg(env);
     }
 
-    uint16_t channels              = wav.channels;
-    uint32_t sample_rate           = wav.sampleRate;
-    uint64_t total_PCM_frame_count = wav.totalPCMFrameCount;
+    reader->lock();
+    if (!reader->m_opened) {
+        reader->unlock();
+        return enif_make_badarg(env);
+    }
+
+    const uint16_t channels = reader->m_wav.channels;
+    const uint64_t remains  = reader->m_wav.totalPCMFrameCount - reader->m_wav.readCursorInPCMFrames;
+    if (frames > remains) {
+        frames = remains;
+    }
+    if (frames == 0) {
+        reader->unlock();
+        return enif_make_atom_ex(env, "eof");
+    }
 
     ErlNifBinary pcm_f32;
-    enif_alloc_binary(total_PCM_frame_count * channels * sizeof(float), &pcm_f32);
+    if (!enif_alloc_binary(frames * channels * sizeof(float), &pcm_f32)) {
+        reader->unlock();
+        return enif_make_error(env);
+    }
 
-    drwav_read_pcm_frames_f32(&wav, total_PCM_frame_count, (float*)pcm_f32.data);
+    uint64_t count = drwav_read_pcm_frames_f32(&reader->m_wav, frames, (float*)pcm_f32.data);
+    reader->unlock();
 
-    drwav_uninit(&wav);
+    if (count < frames) {
+        enif_realloc_binary(&pcm_f32, count * channels * sizeof(float));
+    }
 
-    return enif_make_ok(env,
-             enif_make_tuple3(env,
-                enif_make_uint(env, channels),
-                enif_make_uint(env, sample_rate),
-                enif_make_binary(env, &pcm_f32)));
+    return enif_make_ok(env, enif_make_binary(env, &pcm_f32));
+}
+
+/***  Module Header  ******************************************************}}}*/
+/**
+* Seek WAV file
+* @par DESCRIPTION
+*   Move the read position to the specified PCM frame.
+*
+* @retval :ok
+**/
+/**************************************************************************{{{*/
+DECL_NIF_DIRTY_IO(wav_seek) {
+    WavReader* reader;
+    ErlNifUInt64 frame;
+
+    if (ality != 2
+    || !Resource<WavReader>::get_item(env, term[0], &reader)
+    || !enif_get_uint64(env, term[1], &frame)) {
+        return enif_make_badarg(env);
+    }
+
+    reader->lock();
+    bool done = reader->m_opened
+             && frame <= reader->m_wav.totalPCMFrameCount
+             && drwav_seek_to_pcm_frame(&reader->m_wav, frame);
+    reader->unlock();
+
+    return done ? enif_make_ok(env) : enif_make_badarg(env);
+}
+
+/***  Module Header  ******************************************************}}}*/
+/**
+* Close WAV file
+* @par DESCRIPTION
+*   Release the decoder before the resource is garbage collected.
+*
+* @retval :ok
+**/
+/**************************************************************************{{{*/
+DECL_NIF_DIRTY_IO(wav_close) {
+    WavReader* reader;
+
+    if (ality != 1
+    || !Resource<WavReader>::get_item(env, term[0], &reader)) {
+        return enif_make_badarg(env);
+    }
+
+    reader->lock();
+    reader->close();
+    reader->unlock();
+
+    return enif_make_ok(env);
+}
+
+/***  Module Header  ******************************************************}}}*/
+/**
+* Write PCM frames
+* @par DESCRIPTION
+*   Convert f32 PCM to the sample format of the opened drwav and write it.
+*   The conversion goes through a stack buffer of WAV_CHUNK_SAMPLES, so no
+*   copy of the whole signal is allocated; f32 is written as it is.
+*
+* @retval succeed or fail
+**/
+/**************************************************************************{{{*/
+static bool _wav_write_pcm(drwav& wav, const ErlNifBinary& pcm_f32, int sample_format)
+{
+    const size_t   channels = wav.channels;
+    const uint64_t n_frames = pcm_f32.size/(channels*sizeof(float));
+    const float*   src      = (const float*)pcm_f32.data;
+
+    if (sample_format == WAV_F32) {
+        return drwav_write_pcm_frames(&wav, n_frames, src) == n_frames;
+    }
+
+    if (channels > WAV_CHUNK_SAMPLES) {
+        return false;
+    }
+
+    uint8_t chunk[WAV_CHUNK_SAMPLES*3];
+    const uint64_t chunk_frames = WAV_CHUNK_SAMPLES / channels;
+
+    for (uint64_t done = 0; done < n_frames; ) {
+        const uint64_t frames  = std::min(chunk_frames, n_frames - done);
+        const size_t   samples = frames*channels;
+
+        if (sample_format == WAV_S16) {
+            drwav_f32_to_s16((drwav_int16*)chunk, src, samples);
+        }
+        else {
+            // 24-bit little endian, clipped to [-1, 1].
+            for (size_t i = 0; i < samples; i++) {
+                float x = std::max(-1.0f, std::min(1.0f, src[i]));
+                int32_t v = int32_t(std::lrintf(x*8388607.0f));
+                chunk[3*i  ] = uint8_t(v);
+                chunk[3*i+1] = uint8_t(v >> 8);
+                chunk[3*i+2] = uint8_t(v >> 16);
+            }
+        }
+
+        if (drwav_write_pcm_frames(&wav, frames, chunk) != frames) {
+            return false;
+        }
+        src  += samples;
+        done += frames;
+    }
+
+    return true;
+}
+
+static drwav_data_format _wav_format(unsigned int channels, unsigned int sample_rate, int sample_format)
+{
+    drwav_data_format format;
+    format.container     = drwav_container_riff;
+    format.format        = (sample_format == WAV_F32) ? DR_WAVE_FORMAT_IEEE_FLOAT : DR_WAVE_FORMAT_PCM;
+    format.channels      = channels;
+    format.sampleRate    = sample_rate;
+    format.bitsPerSample = (sample_format == WAV_S16) ? 16
+                         : (sample_format == WAV_S24) ? 24
+                         : 32;
+
+    return format;
 }
 
 /***  Module Header  ******************************************************}}}*/
 /**
 * Save WAV file
 * @par DESCRIPTION
-*   Save audio data to specific WAV file.
+*   Save audio data to specific WAV file in the sample format.
 *
 * @retval :ok
 **/
 /**************************************************************************{{{*/
-DECL_NIF(wav_save) {
+DECL_NIF_DIRTY_IO(wav_save) {
     std::string  fname;
     unsigned int channels;
     unsigned int sample_rate;
     ErlNifBinary pcm_f32;
+    int          sample_format;
 
-    if (ality != 4
+    if (ality != 5
     || !enif_get_str(env, term[0], &fname)
     || !enif_get_uint(env, term[1], &channels)
     || !enif_get_uint(env, term[2], &sample_rate)
-    || !enif_inspect_binary(env, term[3], &pcm_f32)) {
+    || !enif_inspect_binary(env, term[3], &pcm_f32)
+    || !enif_align_binary(env, pcm_f32, alignof(float))
+    || !enif_get_wav_sample_format(env, term[4], &sample_format)
+    || channels == 0
+    || pcm_f32.size % (channels*sizeof(float)) != 0) {
         return enif_make_badarg(env);
     }
 
-    drwav_data_format format;
-    format.container     = drwav_container_riff;
-    format.format        = DR_WAVE_FORMAT_PCM;
-    format.channels      = channels;
-    format.sampleRate    = sample_rate;
-    format.bitsPerSample = 16;
+    drwav_data_format format = _wav_format(channels, sample_rate, sample_format);
 
     drwav wav;
     if (!drwav_init_file_write(&wav, fname.c_str(), &format, NULL)) {
         return enif_make_badarg(env);
     }
 
-    // convert f32 to s16
-    size_t total_count = pcm_f32.size/sizeof(float);
-    int16_t* pcm_s16 = (int16_t*)calloc(total_count, sizeof(int16_t));
-    if (pcm_s16 == NULL) {
+    bool done = _wav_write_pcm(wav, pcm_f32, sample_format);
+    drwav_uninit(&wav);
+
+    return done ? enif_make_ok(env) : enif_make_error(env);
+}
+
+/***  Module Header  ******************************************************}}}*/
+/**
+* Encode WAV binary
+* @par DESCRIPTION
+*   Encode audio data to WAV image on memory in the sample format.
+*
+* @retval {:ok, binary}
+**/
+/**************************************************************************{{{*/
+DECL_NIF_DIRTY_CPU(wav_encode) {
+    unsigned int channels;
+    unsigned int sample_rate;
+    ErlNifBinary pcm_f32;
+    int          sample_format;
+
+    if (ality != 4
+    || !enif_get_uint(env, term[0], &channels)
+    || !enif_get_uint(env, term[1], &sample_rate)
+    || !enif_inspect_binary(env, term[2], &pcm_f32)
+    || !enif_align_binary(env, pcm_f32, alignof(float))
+    || !enif_get_wav_sample_format(env, term[3], &sample_format)
+    || channels == 0
+    || pcm_f32.size % (channels*sizeof(float)) != 0) {
+        return enif_make_badarg(env);
+    }
+
+    drwav_data_format format = _wav_format(channels, sample_rate, sample_format);
+
+    void*  image      = NULL;
+    size_t image_size = 0;
+
+    drwav wav;
+    if (!drwav_init_memory_write(&wav, &image, &image_size, &format, NULL)) {
         return enif_make_error(env);
     }
-    drwav_f32_to_s16(pcm_s16, (const float*)pcm_f32.data, total_count);
 
-    // save as 16-bit PCM.
-    drwav_write_pcm_frames(&wav, total_count/channels, pcm_s16);
+    bool done = _wav_write_pcm(wav, pcm_f32, sample_format);
+    drwav_uninit(&wav);     // image is completed here.
 
-    free(pcm_s16);
-    drwav_uninit(&wav);
+    if (!done) {
+        drwav_free(image, NULL);
+        return enif_make_error(env);
+    }
+
+    ERL_NIF_TERM output;
+    std::memcpy(enif_make_new_binary(env, image_size, &output), image, image_size);
+    drwav_free(image, NULL);
+
+    return enif_make_ok(env, output);
+}
+
+/***  Module Header  ******************************************************}}}*/
+/**
+* Open WAV file for writing
+* @par DESCRIPTION
+*   Create the WAV file and keep its encoder in the resource.
+*
+* @retval {:ok, writer}
+**/
+/**************************************************************************{{{*/
+DECL_NIF_DIRTY_IO(wav_writer_open) {
+    std::string  fname;
+    unsigned int channels;
+    unsigned int sample_rate;
+    int          sample_format;
+
+    if (ality != 4
+    || !enif_get_str(env, term[0], &fname)
+    || !enif_get_uint(env, term[1], &channels)
+    || !enif_get_uint(env, term[2], &sample_rate)
+    || !enif_get_wav_sample_format(env, term[3], &sample_format)
+    || channels == 0 || channels > WAV_CHUNK_SAMPLES) {
+        return enif_make_badarg(env);
+    }
+
+    WavWriter* writer = new WavWriter(sample_format);
+    if (!writer->open(fname.c_str(), _wav_format(channels, sample_rate, sample_format))) {
+        delete writer;
+        return enif_make_badarg(env);
+    }
+
+    return Resource<WavWriter>::make_resource(env, writer);
+}
+
+/***  Module Header  ******************************************************}}}*/
+/**
+* Append to WAV file
+* @par DESCRIPTION
+*   Append f32 PCM frames to the WAV file of the writer.
+*
+* @retval :ok
+**/
+/**************************************************************************{{{*/
+DECL_NIF_DIRTY_IO(wav_write) {
+    WavWriter* writer;
+    ErlNifBinary pcm_f32;
+
+    if (ality != 2
+    || !Resource<WavWriter>::get_item(env, term[0], &writer)
+    || !enif_inspect_binary(env, term[1], &pcm_f32)
+    || !enif_align_binary(env, pcm_f32, alignof(float))) {
+        return enif_make_badarg(env);
+    }
+
+    writer->lock();
+    if (!writer->m_opened
+    ||  pcm_f32.size % (writer->m_wav.channels*sizeof(float)) != 0) {
+        writer->unlock();
+        return enif_make_badarg(env);
+    }
+    bool done = _wav_write_pcm(writer->m_wav, pcm_f32, writer->m_sample_format);
+    writer->unlock();
+
+    return done ? enif_make_ok(env) : enif_make_error(env);
+}
+
+/***  Module Header  ******************************************************}}}*/
+/**
+* Close WAV writer
+* @par DESCRIPTION
+*   Complete the header and close the WAV file.
+*
+* @retval :ok
+**/
+/**************************************************************************{{{*/
+DECL_NIF_DIRTY_IO(wav_writer_close) {
+    WavWriter* writer;
+
+    if (ality != 1
+    || !Resource<WavWriter>::get_item(env, term[0], &writer)) {
+        return enif_make_badarg(env);
+    }
+
+    writer->lock();
+    writer->close();
+    writer->unlock();
 
     return enif_make_ok(env);
 }
 
 /***  Module Header  ******************************************************}}}*/
 /**
-* Load WAV file
+* Chunk wave into frames
 * @par DESCRIPTION
-*   Load audio data from specific WAV file.
+*   Copy the overlapping frames of wave into matrix[n_frames, window].
+*   Mozu.FrameView avoids this copy by passing the base signal and hop to
+*   the FFT/feature NIFs instead.
 *
-* @retval binary
+* @retval matrix[n_frames, window]
 **/
 /**************************************************************************{{{*/
+template <typename T>
+ERL_NIF_TERM _to_frames_nif(ErlNifEnv* env, const PaddedView<float>& wave, size_t hop, size_t window)
+{
+    // the last frame ending exactly at the end of wave is included.
+    const size_t n_frames = (wave.size() >= window) ? 1 + (wave.size() - window)/hop : 0;
+
+    BinaryArray<T> frames;
+    if (!frames.alloc(n_frames*window)) {
+        return enif_make_error(env);
+    }
+
+    for (size_t t = 0; t < n_frames; t++) {
+        wave.copy(t*hop, window, &frames[t*window]);
+    }
+
+    return enif_make_ok(env, enif_make_array(env, frames));
+}
+
 DECL_NIF(to_frames) {
-    std::vector<float> wave;
+    ArrayView<const float> wave;
     int hop;
     int window;
     bool center;
+    std::string dtype;
 
-    if (ality != 4
-    || !enif_get_vector(env, term[0], wave)
+    if (ality != 5
+    || !enif_get_view(env, term[0], wave)
     || !enif_get_int(env, term[1], &hop)
     || !enif_get_int(env, term[2], &window)
-    || !enif_get_bool(env, term[3], &center)) {
+    || !enif_get_bool(env, term[3], &center)
+    || !enif_get_str(env, term[4], dtype)
+    || hop < 1 || window < 1 || wave.empty()) {
         return enif_make_badarg(env);
     }
 
-    if (center) {
-        const int half_window = int(window / 2);
-        _pad(wave, half_window, half_window, PAD_REFLECT);
-    }
+    YIELD_TO_DIRTY_CPU(to_frames, wave.size()*window/hop);
 
-    std::vector<double> frames;
-    for (auto src = wave.begin(); src < wave.end() - window; src += hop) {
-        std::vector<double> frame(src, src+window);
-   
-        std::copy(frame.begin(), frame.end(), std::back_inserter(frames));
-    }
+    // center: the reflect padding of the boundary frames is synthesized on the fly.
+    const size_t half_window = center ? window/2 : 0;
+    PaddedView<float> padded(wave.data(), wave.size(), half_window, half_window, PAD_REFLECT);
 
-    return enif_make_ok(env, enif_make_vector(env, std::move(frames)));
+    return (dtype == "<f4") ? _to_frames_nif<float>(env, padded, hop, window)
+         : (dtype == "<f8") ? _to_frames_nif<double>(env, padded, hop, window)
+         : enif_make_badarg(env);
 }
 
 /***  Module Header  ******************************************************}}}*/
 /**
-* dtype conversion
+* pad array
 * @par DESCRIPTION
-*   
+*   Pad the wave with zero, edge or reflect samples.
 *
-* @retval 
+* @retval padded wave
 **/
 /**************************************************************************{{{*/
 DECL_NIF(pad) {
-    std::vector<float> array;
+    ArrayView<const float> array;
     unsigned int front_size;
     unsigned int rear_size;
     unsigned int mode;
 
     if (ality != 4
-    || !enif_get_vector(env, term[0], array)
+    || !enif_get_view(env, term[0], array)
     || !enif_get_uint(env, term[1], &front_size)
     || !enif_get_uint(env, term[2], &rear_size)
-    || !enif_get_uint(env, term[3], &mode)) {
+    || !enif_get_uint(env, term[3], &mode)
+    || array.empty()
+    || mode > PAD_REFLECT) {
         return enif_make_badarg(env);
     }
 
-    _pad(array, front_size, rear_size, mode);
+    YIELD_TO_DIRTY_CPU(pad, array.size() + front_size + rear_size);
+
+    BinaryArray<float> padded;
+    if (!padded.alloc(front_size + array.size() + rear_size)) {
+        return enif_make_error(env);
+    }
+
+    _pad(array.data(), array.size(), padded.data(), front_size, rear_size, mode);
 
-    return enif_make_ok(env, enif_make_vector(env, move(array)));
+    return enif_make_ok(env, enif_make_array(env, padded));
 }
 
 
@@ -188,48 +723,34 @@ DECL_NIF(pad) {
 * @retval 
 **/
 /**************************************************************************{{{*/
-template <typename T>
-std::vector<T> _hanning(int N)
-{
-    std::vector<T> w(N);
-    for (int i = 0; i < N; i++) {
-        w[i] = 0.5*(1 - cos(2*M_PI*i/(N-1))); 
-    }
-
-    return w;
-}
-
 DECL_NIF(hanning) {
     unsigned int N;
+    std::string dtype;
 
-    if (ality != 1
-    || !enif_get_uint(env, term[0], &N)) {
+    if (ality != 2
+    || !enif_get_uint(env, term[0], &N)
+    || !enif_get_str(env, term[1], dtype)) {
         return enif_make_badarg(env);
     }
 
-    return enif_make_ok(env, enif_make_vector(env, _hanning<double>(N)));
-}
-
-template <typename T>
-std::vector<T> _hamming(int N)
-{
-    std::vector<T> w(N);
-    for (int i = 0; i < N; i++) {
-        w[i] = 0.54 - 0.46*cos(2*M_PI*i/(N-1)); 
-    }
-
-    return w;
+    return (dtype == "<f4") ? enif_make_ok(env, enif_make_vector(env, _hanning<float>(N)))
+         : (dtype == "<f8") ? enif_make_ok(env, enif_make_vector(env, _hanning<double>(N)))
+         : enif_make_badarg(env);
 }
 
 DECL_NIF(hamming) {
     unsigned int N;
+    std::string dtype;
 
-    if (ality != 1
-    || !enif_get_uint(env, term[0], &N)) {
+    if (ality != 2
+    || !enif_get_uint(env, term[0], &N)
+    || !enif_get_str(env, term[1], dtype)) {
         return enif_make_badarg(env);
     }
 
-    return enif_make_ok(env, enif_make_vector(env, _hamming<double>(N)));
+    return (dtype == "<f4") ? enif_make_ok(env, enif_make_vector(env, _hamming<float>(N)))
+         : (dtype == "<f8") ? enif_make_ok(env, enif_make_vector(env, _hamming<double>(N)))
+         : enif_make_badarg(env);
 }
 
 /*** audio.cpp *****************************************************}}}*/
@@ -0,0 +1,239 @@
+/***  File Header  ************************************************************/
+/**
+* audio.h
+*
+* Elixir/Erlang Port ext. of Post-processing for DNN.
+* @author   Shozo Fukuda
+* @date     create 2026-10-17 13:20:05
+* System    Windows10, WSL2/Ubuntu 20.04.2<br>
+*
+**/
+/**************************************************************************{{{*/
+#ifndef _AUDIO_H
+#define _AUDIO_H
+
+#include "my_erl_nif.h"
+#include "dr_wav.h"
+#include <cstring>
+#include <cmath>
+
+/***  Module Header  ******************************************************}}}*/
+/**
+* decode layout
+* @par DESCRIPTION
+*   How the channels of the PCM frames are laid out on decoding:
+*   :interleaved, :mono (downmix), {:channel, n} or :split (one binary per
+*   channel).
+*
+* @retval true if term is a valid layout
+**/
+/**************************************************************************{{{*/
+enum WavLayoutMode {
+    WAV_INTERLEAVED = 0,
+    WAV_MONO,
+    WAV_CHANNEL,
+    WAV_SPLIT
+};
+
+struct WavLayout {
+    int      mode;
+    unsigned channel;
+};
+
+inline bool enif_get_wav_layout(ErlNifEnv* env, ERL_NIF_TERM term, WavLayout* layout)
+{
+    char name[16];
+    const ERL_NIF_TERM* tuple;
+    int arity;
+
+    layout->channel = 0;
+
+    if (enif_get_atom(env, term, name, sizeof(name), ERL_NIF_LATIN1)) {
+        layout->mode = (std::strcmp(name, "interleaved") == 0) ? WAV_INTERLEAVED
+                     : (std::strcmp(name, "mono"       ) == 0) ? WAV_MONO
+                     : (std::strcmp(name, "split"      ) == 0) ? WAV_SPLIT
+                     : -1;
+        return layout->mode >= 0;
+    }
+
+    if (enif_get_tuple(env, term, &arity, &tuple)
+    &&  arity == 2
+    &&  enif_get_atom(env, tuple[0], name, sizeof(name), ERL_NIF_LATIN1)
+    &&  std::strcmp(name, "channel") == 0
+    &&  enif_get_uint(env, tuple[1], &layout->channel)) {
+        layout->mode = WAV_CHANNEL;
+        return true;
+    }
+
+    return false;
+}
+
+/***  Module Header  ******************************************************}}}*/
+/**
+* sample format
+* @par DESCRIPTION
+*   Sample format of the WAV to write: :s16, :s24 (PCM) or :f32 (IEEE float).
+*
+* @retval true if term is a valid format
+**/
+/**************************************************************************{{{*/
+enum WavSampleFormat {
+    WAV_S16 = 0,
+    WAV_S24,
+    WAV_F32
+};
+
+inline bool enif_get_wav_sample_format(ErlNifEnv* env, ERL_NIF_TERM term, int* sample_format)
+{
+    char name[8];
+
+    if (!enif_get_atom(env, term, name, sizeof(name), ERL_NIF_LATIN1)) {
+        return false;
+    }
+
+    *sample_format = (std::strcmp(name, "s16") == 0) ? WAV_S16
+                   : (std::strcmp(name, "s24") == 0) ? WAV_S24
+                   : (std::strcmp(name, "f32") == 0) ? WAV_F32
+                   : -1;
+
+    return *sample_format >= 0;
+}
+
+/***  Module Header  ******************************************************}}}*/
+/**
+* frame position
+* @par DESCRIPTION
+*   PCM frame position/length given in frames (integer) or in seconds
+*   (float), resolved at the sample rate of the stream once it is known.
+*   nil takes the default.
+*
+* @retval true if term is a valid position
+**/
+/**************************************************************************{{{*/
+enum WavFrameUnit {
+    WAV_DEFAULT = 0,
+    WAV_FRAMES,
+    WAV_SECONDS
+};
+
+struct WavFrames {
+    int      unit;
+    uint64_t count;
+    double   seconds;
+
+    uint64_t resolve(uint32_t sample_rate, uint64_t deflt) const {
+        return (unit == WAV_FRAMES)  ? count
+             : (unit == WAV_SECONDS) ? uint64_t(std::llround(seconds*sample_rate))
+             : deflt;
+    }
+};
+
+inline bool enif_get_wav_frames(ErlNifEnv* env, ERL_NIF_TERM term, WavFrames* frames)
+{
+    ErlNifUInt64 count;
+    double seconds;
+
+    frames->unit    = WAV_DEFAULT;
+    frames->count   = 0;
+    frames->seconds = 0.0;
+
+    if (enif_is_identical(term, enif_make_atom(env, "nil"))) {
+        return true;
+    }
+    if (enif_get_uint64(env, term, &count)) {
+        frames->unit  = WAV_FRAMES;
+        frames->count = count;
+        return true;
+    }
+    if (enif_get_double(env, term, &seconds) && seconds >= 0.0) {
+        frames->unit    = WAV_SECONDS;
+        frames->seconds = seconds;
+        return true;
+    }
+
+    return false;
+}
+
+/***  Class Header  *******************************************************}}}*/
+/**
+* WAV file reader
+* @par description
+*   keep the drwav handle open in the NIF resource, and read PCM frames
+*   chunk by chunk. the handle may be shared between processes, so every
+*   access is serialized by the mutex.
+**/
+/**************************************************************************{{{*/
+class WavReader {
+public:
+    WavReader() : m_opened(false) {
+        m_mutex = enif_mutex_create((char*)"mozu.wav_reader");
+    }
+
+    ~WavReader() {
+        close();
+        enif_mutex_destroy(m_mutex);
+    }
+
+    bool open(const char* fname) {
+        m_opened = drwav_init_file(&m_wav, fname, NULL);
+        return m_opened;
+    }
+
+    void close() {
+        if (m_opened) {
+            drwav_uninit(&m_wav);
+            m_opened = false;
+        }
+    }
+
+    void lock()   { enif_mutex_lock(m_mutex);   }
+    void unlock() { enif_mutex_unlock(m_mutex); }
+
+    drwav        m_wav;
+    bool         m_opened;
+    ErlNifMutex* m_mutex;
+};
+
+/***  Class Header  *******************************************************}}}*/
+/**
+* WAV file writer
+* @par description
+*   keep the drwav encoder open in the NIF resource, and append PCM frames
+*   chunk by chunk. the header is completed on close (or when the resource
+*   is garbage collected). every access is serialized by the mutex.
+**/
+/**************************************************************************{{{*/
+class WavWriter {
+public:
+    WavWriter(int sample_format) : m_opened(false), m_sample_format(sample_format) {
+        m_mutex = enif_mutex_create((char*)"mozu.wav_writer");
+    }
+
+    ~WavWriter() {
+        close();
+        enif_mutex_destroy(m_mutex);
+    }
+
+    bool open(const char* fname, const drwav_data_format& format) {
+        m_opened = drwav_init_file_write(&m_wav, fname, &format, NULL);
+        return m_opened;
+    }
+
+    void close() {
+        if (m_opened) {
+            drwav_uninit(&m_wav);
+            m_opened = false;
+        }
+    }
+
+    void lock()   { enif_mutex_lock(m_mutex);   }
+    void unlock() { enif_mutex_unlock(m_mutex); }
+
+    drwav        m_wav;
+    bool         m_opened;
+    int          m_sample_format;
+    ErlNifMutex* m_mutex;
+};
+
+#endif
+/*** audio.h *************************************************************}}}*/
@@ -0,0 +1,461 @@
+/***  File Header  ************************************************************/
+/**
+* feature.cc
+*
+* Elixir/Erlang Port ext. of Post-processing for DNN.
+* @author   Shozo Fukuda
+* @date     create 2026-10-17 09:12:40
+* System    Windows10, WSL2/Ubuntu 20.04.2<br>
+*
+**/
+/**************************************************************************{{{*/
+
+#include "my_erl_nif.h"
+#include <vector>
+#include <map>
+#include <mutex>
+#include <algorithm>
+#include <cstdint>
+#include <cmath>
+#include <type_traits>
+
+#include "feature.h"
+#include "thread_pool.h"
+#include "async_job.h"
+
+/***  Module Header  ******************************************************}}}*/
+/**
+* feature extractor cache
+* @par DESCRIPTION
+*   Return the shared feature extractor of the configuration. It is built
+*   at the first request, and reused by every process after that. When the
+*   cache is full, the least recently used entry is dropped whoever still
+*   references it: its resources keep their own shared pointer.
+*
+* @retval feature extractor
+**/
+/**************************************************************************{{{*/
+#define FEATURE_CACHE_SIZE  32
+
+std::shared_ptr<const FeatureExtractor> FeatureExtractor::get(const FeatureConfig& config)
+{
+    struct Entry {
+        FeatureHandle extractor;
+        uint64_t      used;
+    };
+    static std::mutex mutex;
+    static std::map<FeatureConfig, Entry> cache;
+    static uint64_t clock = 0;
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto found = cache.find(config);
+    if (found != cache.end()) {
+        found->second.used = ++clock;
+        return found->second.extractor;
+    }
+
+    if (cache.size() >= FEATURE_CACHE_SIZE) {
+        auto lru = std::min_element(cache.begin(), cache.end(), [](const auto& a, const auto& b) {
+            return a.second.used < b.second.used;
+        });
+        cache.erase(lru);
+    }
+
+    FeatureHandle extractor = std::make_shared<const FeatureExtractor>(config);
+    cache.emplace(config, Entry{extractor, ++clock});
+
+    return extractor;
+}
+
+/***  Module Header  ******************************************************}}}*/
+/**
+* create feature extractor
+* @par DESCRIPTION
+*   Get the cached feature extractor of the parameters as resource.
+*
+* @retval {:ok, feature_extractor}
+**/
+/**************************************************************************{{{*/
+DECL_NIF(feature_extractor) {
+    FeatureConfig config;
+
+    if (ality != 8
+    || !enif_get_int(env, term[0], &config.n_fft)
+    || !enif_get_int(env, term[1], &config.hop)
+    || !enif_get_int(env, term[2], &config.n_mels)
+    || !enif_get_number(env, term[3], &config.min_frequency)
+    || !enif_get_number(env, term[4], &config.max_frequency)
+    || !enif_get_int(env, term[5], &config.sampling_rate)
+    || !enif_get_mel_scale(env, term[6], &config.mel_scale)
+    || !enif_get_bool(env, term[7], &config.norm)
+    || config.n_fft < 2 || config.hop < 1 || config.n_mels < 1) {
+        return enif_make_badarg(env);
+    }
+
+    YIELD_TO_DIRTY_CPU(feature_extractor, 4*config.n_fft*(config.n_mels + 2));
+
+    return Resource<FeatureHandle>::make_resource(env, new FeatureHandle(FeatureExtractor::get(config)));
+}
+
+/***  Module Header  ******************************************************}}}*/
+/**
+* log-mel spectrogram
+* @par DESCRIPTION
+*   Compute the normalized log mel spectrogram from the waveform in two
+*   passes. Pass 1 windows, transforms and projects each frame onto the mel
+*   filter bank through reused scratch buffers and takes the log, tracking
+*   the max; pass 2 applies the dynamic range of the normalization and
+*   writes the output type. <f4/<f8 are computed in the output itself,
+*   <f2 in a float32 scratch converted by pass 2.
+*
+* @retval matrix[n_mels, n_frames]
+**/
+/**************************************************************************{{{*/
+template <typename T, typename U>
+void _log_mel_into(const FeatureExtractor& fe, const PaddedView<float>& wave, size_t n_frames, const LogMelNorm& norm, U* output, std::vector<T>& scratch)
+{
+    const size_t count = fe.n_mels()*n_frames;
+
+    T* work = reinterpret_cast<T*>(output);
+    if (!std::is_same<T, U>::value) {
+        scratch.resize(count);
+        work = scratch.data();
+    }
+
+    T max = fe.log_mel(wave, n_frames, norm, work);
+    FeatureExtractor::normalize(work, count, norm, max, output);
+}
+
+template <typename T, typename U>
+ERL_NIF_TERM _log_mel_spectrogram_nif(ErlNifEnv* env, const FeatureExtractor& fe, const PaddedView<float>& wave, const LogMelNorm& norm)
+{
+    const size_t n_frames = fe.n_frames(wave.size());
+
+    BinaryArray<U> log_mel;
+    if (!log_mel.alloc(fe.n_mels()*n_frames)) {
+        return enif_make_error(env);
+    }
+
+    std::vector<T> scratch;
+    _log_mel_into(fe, wave, n_frames, norm, log_mel.data(), scratch);
+
+    return enif_make_ok(env, enif_make_array(env, log_mel));
+}
+
+template <typename T, typename U>
+AsyncCompute _log_mel_spectrogram_job(const FeatureHandle& fe, const ArrayView<const float>& wave, bool center, const LogMelNorm& norm)
+{
+    return [=](ErlNifEnv* env) {
+        // center: the reflect padding is synthesized for the boundary frames only.
+        const size_t half_window = center ? fe->n_fft()/2 : 0;
+        PaddedView<float> padded(wave.data(), wave.size(), half_window, half_window, PAD_REFLECT);
+
+        return _log_mel_spectrogram_nif<T,U>(env, *fe, padded, norm);
+    };
+}
+
+DECL_VALIDATE(log_mel_spectrogram) {
+    FeatureHandle* extractor;
+    ArrayView<const float> wave;
+    bool center;
+    std::string dtype;
+    LogMelNorm norm;
+
+    if (ality != 5
+    || !Resource<FeatureHandle>::get_item(env, term[0], &extractor)
+    || !enif_get_view(env, term[1], wave)
+    || !enif_get_bool(env, term[2], &center)
+    || !enif_get_str(env, term[3], dtype)
+    || !enif_get_log_mel_norm(env, term[4], &norm)
+    || wave.empty()) {
+        return false;
+    }
+
+    *work = wave.size()*std::log2((**extractor).n_fft() + 1);
+
+    compute = (dtype == "<f4") ? _log_mel_spectrogram_job<float,float>(*extractor, wave, center, norm)
+            : (dtype == "<f8") ? _log_mel_spectrogram_job<double,double>(*extractor, wave, center, norm)
+            : (dtype == "<f2") ? _log_mel_spectrogram_job<float,float16>(*extractor, wave, center, norm)
+            : AsyncCompute();
+
+    return bool(compute);
+}
+
+DECL_NIF_DIRTY_CPU(log_mel_spectrogram) {
+    AsyncCompute compute;
+    double work;
+
+    if (!log_mel_spectrogram_validate(env, ality, term, compute, &work)) {
+        return enif_make_badarg(env);
+    }
+
+    return compute(env);
+}
+
+/***  Module Header  ******************************************************}}}*/
+/**
+* batch log-mel spectrogram
+* @par DESCRIPTION
+*   Compute the log mel spectrograms of the clips into one [B, n_mels, T]
+*   array. Each clip is trimmed or zero padded to `length` samples, so that
+*   every clip has the same T. The clips are shared out to the thread pool
+*   and the frames of each clip are split further, so a batch smaller than
+*   the pool still fills it; every clip is written straight into its slice
+*   of the output.
+*
+* @retval tensor[B, n_mels, T]
+**/
+/**************************************************************************{{{*/
+template <typename T, typename U>
+ERL_NIF_TERM _log_mel_batch_nif(ErlNifEnv* env, const FeatureExtractor& fe, const std::vector<ArrayView<const float>>& clips,
+                                size_t length, bool center, const LogMelNorm& norm)
+{
+    const size_t half_window = center ? fe.n_fft()/2 : 0;
+    const size_t n_frames    = fe.n_frames(length + 2*half_window);
+    const size_t stride      = fe.n_mels()*n_frames;
+
+    BinaryArray<U> batch;
+    if (!batch.alloc(clips.size()*stride)) {
+        return enif_make_error(env);
+    }
+
+    parallel_for(clips.size(), 1, [&](size_t begin, size_t end) {
+        std::vector<float> padded_clip;
+        std::vector<T>     scratch;
+
+        for (size_t b = begin; b < end; b++) {
+            const float* wave = clips[b].data();
+            if (clips[b].size() < length) {
+                padded_clip.assign(length, 0.0f);
+                std::copy(clips[b].begin(), clips[b].end(), padded_clip.begin());
+                wave = padded_clip.data();
+            }
+
+            PaddedView<float> padded(wave, length, half_window, half_window, PAD_REFLECT);
+            _log_mel_into(fe, padded, n_frames, norm, &batch[b*stride], scratch);
+        }
+    });
+
+    return enif_make_ok(env, enif_make_tuple2(env, enif_make_uint(env, n_frames), batch.release(env)));
+}
+
+template <typename T, typename U>
+AsyncCompute _log_mel_batch_job(const FeatureHandle& fe, const std::vector<ArrayView<const float>>& clips,
+                                size_t length, bool center, const LogMelNorm& norm)
+{
+    return [=](ErlNifEnv* env) { return _log_mel_batch_nif<T,U>(env, *fe, clips, length, center, norm); };
+}
+
+DECL_VALIDATE(log_mel_batch) {
+    FeatureHandle* extractor;
+    unsigned length;
+    bool center;
+    std::string dtype;
+    LogMelNorm norm;
+
+    if (ality != 6
+    || !Resource<FeatureHandle>::get_item(env, term[0], &extractor)
+    || !enif_is_list(env, term[1])
+    || !enif_get_uint(env, term[2], &length)
+    || !enif_get_bool(env, term[3], &center)
+    || !enif_get_str(env, term[4], dtype)
+    || !enif_get_log_mel_norm(env, term[5], &norm)
+    || length == 0) {
+        return false;
+    }
+
+    std::vector<ArrayView<const float>> clips;
+    ERL_NIF_TERM list = term[1], head;
+    while (enif_get_list_cell(env, list, &head, &list)) {
+        ArrayView<const float> clip;
+        if (!enif_get_view(env, head, clip)) {
+            return false;
+        }
+        // trimmed to length.
+        clips.emplace_back(clip.data(), std::min<size_t>(clip.size(), length));
+    }
+
+    *work = double(clips.size())*length*std::log2((**extractor).n_fft() + 1);
+
+    compute = (dtype == "<f4") ? _log_mel_batch_job<float,float>(*extractor, clips, length, center, norm)
+            : (dtype == "<f8") ? _log_mel_batch_job<double,double>(*extractor, clips, length, center, norm)
+            : (dtype == "<f2") ? _log_mel_batch_job<float,float16>(*extractor, clips, length, center, norm)
+            : AsyncCompute();
+
+    return bool(compute);
+}
+
+DECL_NIF_DIRTY_CPU(log_mel_batch) {
+    AsyncCompute compute;
+    double work;
+
+    if (!log_mel_batch_validate(env, ality, term, compute, &work)) {
+        return enif_make_badarg(env);
+    }
+
+    return compute(env);
+}
+
+/***  Module Header  ******************************************************}}}*/
+/**
+* MFCC
+* @par DESCRIPTION
+*   Compute MFCC from the waveform natively: the normalized log mel
+*   spectrogram (float32 scratch), the orthonormal DCT-II of each frame by
+*   the cached plan, liftering, and the deltas up to the order stacked
+*   below the coefficients.
+*
+* @retval matrix[(order+1)*n_mfcc, n_frames] of float32
+**/
+/**************************************************************************{{{*/
+static ERL_NIF_TERM _mfcc_nif(ErlNifEnv* env, const FeatureExtractor& fe, const ArrayView<const float>& wave, bool center,
+                              const LogMelNorm& norm, int n_mfcc, double lifter, int order, int width)
+{
+    const size_t half_window = center ? fe.n_fft()/2 : 0;
+    PaddedView<float> padded(wave.data(), wave.size(), half_window, half_window, PAD_REFLECT);
+
+    const size_t n_frames = fe.n_frames(padded.size());
+    const size_t count    = n_mfcc*n_frames;
+
+    BinaryArray<float> mfcc;
+    if (!mfcc.alloc((order + 1)*count)) {
+        return enif_make_error(env);
+    }
+
+    std::vector<float> log_mel(fe.n_mels()*n_frames);
+    float max = fe.log_mel(padded, n_frames, norm, log_mel.data());
+    FeatureExtractor::normalize(log_mel.data(), log_mel.size(), norm, max, log_mel.data());
+
+    fe.cepstrum(log_mel.data(), n_frames, n_mfcc, lifter, mfcc.data());
+    for (int i = 1; i <= order; i++) {
+        FeatureExtractor::delta(&mfcc[(i - 1)*count], n_mfcc, n_frames, width, &mfcc[i*count]);
+    }
+
+    return enif_make_ok(env, enif_make_array(env, mfcc));
+}
+
+DECL_VALIDATE(mfcc) {
+    FeatureHandle* extractor;
+    ArrayView<const float> wave;
+    bool center;
+    LogMelNorm norm;
+    int n_mfcc;
+    double lifter;
+    int order;
+    int width;
+
+    if (ality != 8
+    || !Resource<FeatureHandle>::get_item(env, term[0], &extractor)
+    || !enif_get_view(env, term[1], wave)
+    || !enif_get_bool(env, term[2], &center)
+    || !enif_get_log_mel_norm(env, term[3], &norm)
+    || !enif_get_int(env, term[4], &n_mfcc)
+    || !enif_get_number(env, term[5], &lifter)
+    || !enif_get_int(env, term[6], &order)
+    || !enif_get_int(env, term[7], &width)
+    || wave.empty()
+    || n_mfcc < 1 || n_mfcc > (**extractor).n_mels()
+    || order < 0 || order > 2 || width < 1) {
+        return false;
+    }
+
+    *work = wave.size()*std::log2((**extractor).n_fft() + 1);
+
+    const FeatureHandle fe = *extractor;
+    compute = [=](ErlNifEnv* env) { return _mfcc_nif(env, *fe, wave, center, norm, n_mfcc, lifter, order, width); };
+
+    return true;
+}
+
+DECL_NIF_DIRTY_CPU(mfcc) {
+    AsyncCompute compute;
+    double work;
+
+    if (!mfcc_validate(env, ality, term, compute, &work)) {
+        return enif_make_badarg(env);
+    }
+
+    return compute(env);
+}
+
+/***  Module Header  ******************************************************}}}*/
+/**
+* streaming log-mel spectrogram
+* @par DESCRIPTION
+*   Open the stream resource on the feature extractor, push chunks of PCM
+*   <f4 through it, and flush the frames over the rear padding at the end
+*   of the stream. Each call returns the log mel spectrogram <f4
+*   [n_mels, frames] of the frames completed by it only.
+*
+* @retval {:ok, stream} / log mel spectrogram of the new frames
+**/
+/**************************************************************************{{{*/
+DECL_NIF(log_mel_stream_open) {
+    FeatureHandle* extractor;
+    bool center;
+    LogMelNorm norm;
+
+    if (ality != 3
+    || !Resource<FeatureHandle>::get_item(env, term[0], &extractor)
+    || !enif_get_bool(env, term[1], &center)
+    || !enif_get_log_mel_norm(env, term[2], &norm)) {
+        return enif_make_badarg(env);
+    }
+
+    return Resource<LogMelStream>::make_resource(env, new LogMelStream(*extractor, center, norm));
+}
+
+DECL_NIF(log_mel_stream_push) {
+    LogMelStream* stream;
+    ArrayView<const float> wave;
+
+    if (ality != 2
+    || !Resource<LogMelStream>::get_item(env, term[0], &stream)
+    || !enif_get_view(env, term[1], wave)) {
+        return enif_make_badarg(env);
+    }
+
+    YIELD_TO_DIRTY_CPU(log_mel_stream_push, wave.size()*std::log2(wave.size() + 1));
+
+    stream->lock();
+
+    BinaryArray<float> output;
+    if (!output.alloc(stream->max_output(wave.size())*stream->n_mels())) {
+        stream->unlock();
+        return enif_make_error(env);
+    }
+
+    size_t count = stream->push(wave.data(), wave.size(), output.data());
+    output.shrink(count*stream->n_mels());
+
+    stream->unlock();
+
+    return enif_make_ok(env, enif_make_array(env, output));
+}
+
+DECL_NIF(log_mel_stream_flush) {
+    LogMelStream* stream;
+
+    if (ality != 1
+    || !Resource<LogMelStream>::get_item(env, term[0], &stream)) {
+        return enif_make_badarg(env);
+    }
+
+    stream->lock();
+
+    BinaryArray<float> output;
+    if (!output.alloc(stream->max_output(0)*stream->n_mels())) {
+        stream->unlock();
+        return enif_make_error(env);
+    }
+
+    size_t count = stream->flush(output.data());
+    output.shrink(count*stream->n_mels());
+
+    stream->unlock();
+
+    return enif_make_ok(env, enif_make_array(env, output));
+}
+
+/*** feature.cc **********************************************************}}}*/
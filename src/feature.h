@@ -0,0 +1,446 @@
+/***  File Header  ************************************************************/
+/**
+* feature.h
+*
+* Elixir/Erlang Port ext. of Post-processing for DNN.
+* @author   Shozo Fukuda
+* @date     create 2026-10-17 09:12:40
+* System    Windows10, WSL2/Ubuntu 20.04.2<br>
+*
+**/
+/**************************************************************************{{{*/
+#ifndef _FEATURE_H
+#define _FEATURE_H
+
+#include "my_erl_nif.h"
+#include <vector>
+#include <memory>
+#include <tuple>
+#include <limits>
+#include <cstring>
+#include <mutex>
+
+#include "npy_utils.h"
+#include "fft_utils.h"
+#include "filter_bank.h"
+#include "thread_pool.h"
+
+/***  Class Header  *******************************************************}}}*/
+/**
+* feature extraction parameters
+* @par description
+*   the key of feature extractor cache.
+**/
+/**************************************************************************{{{*/
+struct FeatureConfig {
+    int    n_fft;
+    int    hop;
+    int    n_mels;
+    double min_frequency;
+    double max_frequency;
+    int    sampling_rate;
+    int    mel_scale;
+    bool   norm;
+
+    bool operator<(const FeatureConfig& other) const {
+        return std::tie(n_fft, hop, n_mels, min_frequency, max_frequency, sampling_rate, mel_scale, norm)
+             < std::tie(other.n_fft, other.hop, other.n_mels, other.min_frequency, other.max_frequency, other.sampling_rate, other.mel_scale, other.norm);
+    }
+};
+
+/***  Module Header  ******************************************************}}}*/
+/**
+* log-mel normalization
+* @par DESCRIPTION
+*   The convention of the log and the dynamic range applied to the mel
+*   spectrogram:
+*   :log10        log10(max(x, 1e-10))
+*   :whisper      log10 as above, clamped to max-8 and rescaled by (x+4)/4
+*   {:db, top_db} 10*log10(max(x, 1e-10)) clamped to max-top_db (power_to_db)
+*                 (:db is top_db 80, {:db, nil} no clamp)
+*   :kaldi        ln(max(x, FLT_EPSILON))
+*
+* @retval true if term is a valid normalization
+**/
+/**************************************************************************{{{*/
+enum LogMelMode {
+    LOGMEL_LOG10 = 0,
+    LOGMEL_WHISPER,
+    LOGMEL_DB,
+    LOGMEL_KALDI
+};
+
+struct LogMelNorm {
+    int    mode;
+    double top_db;      // LOGMEL_DB: dynamic range, <= 0 for none
+};
+
+inline bool enif_get_log_mel_norm(ErlNifEnv* env, ERL_NIF_TERM term, LogMelNorm* norm)
+{
+    char name[16];
+    const ERL_NIF_TERM* tuple;
+    int arity;
+
+    norm->top_db = 80.0;
+
+    if (enif_get_atom(env, term, name, sizeof(name), ERL_NIF_LATIN1)) {
+        norm->mode = (std::strcmp(name, "log10"  ) == 0) ? LOGMEL_LOG10
+                   : (std::strcmp(name, "whisper") == 0) ? LOGMEL_WHISPER
+                   : (std::strcmp(name, "db"     ) == 0) ? LOGMEL_DB
+                   : (std::strcmp(name, "kaldi"  ) == 0) ? LOGMEL_KALDI
+                   : -1;
+        return norm->mode >= 0;
+    }
+
+    if (enif_get_tuple(env, term, &arity, &tuple)
+    &&  arity == 2
+    &&  enif_get_atom(env, tuple[0], name, sizeof(name), ERL_NIF_LATIN1)
+    &&  std::strcmp(name, "db") == 0) {
+        norm->mode = LOGMEL_DB;
+        if (enif_is_identical(tuple[1], enif_make_atom(env, "nil"))) {
+            norm->top_db = 0.0;
+            return true;
+        }
+        return enif_get_number(env, tuple[1], &norm->top_db) && norm->top_db > 0.0;
+    }
+
+    return false;
+}
+
+/***  Class Header  *******************************************************}}}*/
+/**
+* per element type kernel
+* @par description
+*   window and FFT plan computing in T (float or double).
+**/
+/**************************************************************************{{{*/
+template <typename T>
+struct FeatureKernel {
+    FeatureKernel(int n_fft) : m_window(_hanning<T>(n_fft)), m_plan(n_fft) {}
+
+    const std::vector<T>                    m_window;
+    const pocketfft::detail::pocketfft_r<T> m_plan;
+};
+
+/***  Class Header  *******************************************************}}}*/
+/**
+* feature extractor
+* @par description
+*   precomputed window, mel filter bank and FFT plan for one configuration.
+*   it is immutable after construction, so one instance is shared by every
+*   process through the cache and may be used concurrently.
+*   the spectrum is computed in float32 or float64 after the output type.
+*   the DCT plan of n_mels serves MFCC.
+**/
+/**************************************************************************{{{*/
+class FeatureExtractor {
+public:
+    static const size_t FRAMES_PER_BLOCK   = 16;
+    static const size_t ELEMENTS_PER_BLOCK = 1 << 16;
+
+    FeatureExtractor(const FeatureConfig& config)
+    : m_config(config),
+      m_mel_bank(_mel_bank(config.n_fft/2 + 1, config.n_mels, config.min_frequency, config.max_frequency, config.sampling_rate,
+                           config.mel_scale, config.norm)),
+      m_f4(config.n_fft),
+      m_f8(config.n_fft),
+      m_dct(config.n_mels)
+    {}
+
+    static std::shared_ptr<const FeatureExtractor> get(const FeatureConfig& config);
+
+    int n_fft()  const { return m_config.n_fft;  }
+    int hop()    const { return m_config.hop;    }
+    int n_mels() const { return m_config.n_mels; }
+    int n_freq() const { return m_config.n_fft/2 + 1; }
+
+    size_t n_frames(size_t size) const {
+        return (size >= size_t(n_fft())) ? 1 + (size - n_fft())/hop() : 0;
+    }
+
+    template <typename T>
+    const FeatureKernel<T>& kernel() const;
+
+    // power spectrum of one frame: frame[n_fft] is the scratch, power[n_freq] the result.
+    template <typename T>
+    void frame_power(const float* src, T* frame, T* power) const
+    {
+        const FeatureKernel<T>& k = kernel<T>();
+
+        const int N = n_fft();
+        for (int i = 0; i < N; i++) {
+            frame[i] = k.m_window[i]*src[i];
+        }
+
+        // halfcomplex: r0, r1, i1, r2, i2, ... (, r[N/2] if N is even)
+        k.m_plan.exec(frame, T(1.0), true);
+
+        // (r1, i1), (r2, i2), ... are complex pairs from frame[1].
+        power[0] = frame[0]*frame[0];
+        _norm(reinterpret_cast<const std::complex<T>*>(&frame[1]), (N+1)/2 - 1, &power[1]);
+        if (N % 2 == 0) {
+            power[N/2] = frame[N-1]*frame[N-1];
+        }
+    }
+
+    // pass 1: log mel spectrogram[n_mels, n_frames] of the (padded) wave; return its max.
+    // only the boundary frames are assembled from the virtual padding, and the
+    // log is taken on each frame's mel vector while it is in cache.
+    // frame blocks run on the thread pool, each with its own scratch.
+    template <typename T>
+    T log_mel(const PaddedView<float>& wave, size_t n_frames, const LogMelNorm& norm, T* output) const
+    {
+        const T floor = (norm.mode == LOGMEL_KALDI) ? T(std::numeric_limits<float>::epsilon()) : T(1e-10);
+        const T scale = (norm.mode == LOGMEL_DB)    ? T(10.0)
+                      : (norm.mode == LOGMEL_KALDI) ? T(M_LN10)
+                      : T(1.0);
+
+        std::mutex mutex;
+        T max = -std::numeric_limits<T>::infinity();
+
+        parallel_for(n_frames, FRAMES_PER_BLOCK, [&](size_t begin, size_t end) {
+            std::vector<float> edge(n_fft());
+            std::vector<T>     frame(n_fft());
+            std::vector<T>     power(n_freq());
+            std::vector<T>     mel(n_mels());
+
+            T block_max = -std::numeric_limits<T>::infinity();
+            for (size_t t = begin; t < end; t++) {
+                const size_t pos = t*hop();
+                const float* src;
+                if (wave.inside(pos, n_fft())) {
+                    src = wave.at(pos);
+                }
+                else {
+                    wave.copy(pos, n_fft(), edge.data());
+                    src = edge.data();
+                }
+
+                frame_power(src, frame.data(), power.data());
+                m_mel_bank.apply(power.data(), mel.data());
+                _log10(mel.data(), n_mels(), floor, mel.data());
+
+                for (int j = 0; j < n_mels(); j++) {
+                    const T y = scale*mel[j];
+                    output[j*n_frames + t] = y;
+                    block_max = std::max(block_max, y);
+                }
+            }
+
+            std::lock_guard<std::mutex> lock(mutex);
+            max = std::max(max, block_max);
+        });
+
+        return max;
+    }
+
+    // pass 2: dynamic range clamp and rescale by the max of pass 1, and
+    // conversion to the output type, in element blocks on the thread pool.
+    // output may overlay input.
+    template <typename T, typename U>
+    static void normalize(const T* input, size_t count, const LogMelNorm& norm, T max, U* output)
+    {
+        if (norm.mode != LOGMEL_WHISPER && !(norm.mode == LOGMEL_DB && norm.top_db > 0.0)
+        &&  (const void*)input == (const void*)output) {
+            return;
+        }
+
+        parallel_for(count, ELEMENTS_PER_BLOCK, [&](size_t begin, size_t end) {
+            switch (norm.mode) {
+            case LOGMEL_WHISPER:
+                for (size_t i = begin; i < end; i++) {
+                    output[i] = U((std::max(input[i], max - T(8.0)) + T(4.0))/T(4.0));
+                }
+                break;
+            case LOGMEL_DB:
+                if (norm.top_db > 0.0) {
+                    for (size_t i = begin; i < end; i++) {
+                        output[i] = U(std::max(input[i], max - T(norm.top_db)));
+                    }
+                    break;
+                }
+                // fall through
+            default:
+                _astype(input + begin, end - begin, output + begin);
+                break;
+            }
+        });
+    }
+
+    // MFCC[n_mfcc, n_frames] of the log mel spectrogram[n_mels, n_frames] by the
+    // orthonormal DCT-II, liftered by 1 + (lifter/2) sin(pi (k+1)/lifter) if lifter > 0.
+    void cepstrum(const float* log_mel, size_t n_frames, int n_mfcc, double lifter, float* output) const
+    {
+        const int N = n_mels();
+
+        std::vector<float> lift(n_mfcc, 1.0f);
+        if (lifter > 0.0) {
+            for (int k = 0; k < n_mfcc; k++) {
+                lift[k] = float(1.0 + 0.5*lifter*std::sin(M_PI*(k + 1)/lifter));
+            }
+        }
+
+        std::vector<float> column(N);
+        for (size_t t = 0; t < n_frames; t++) {
+            for (int j = 0; j < N; j++) {
+                column[j] = log_mel[j*n_frames + t];
+            }
+
+            // unnormalized DCT-II is 2*sum; 1/sqrt(2N) and the ortho flag make it orthonormal.
+            m_dct.exec(column.data(), float(1.0/std::sqrt(2.0*N)), true, 2, true);
+
+            for (int k = 0; k < n_mfcc; k++) {
+                output[k*n_frames + t] = lift[k]*column[k];
+            }
+        }
+    }
+
+    // regression delta of each row[n_frames] over +-width frames, the edges replicated:
+    // d[t] = sum_n n (x[t+n] - x[t-n]) / (2 sum_n n^2)
+    static void delta(const float* input, size_t n_rows, size_t n_frames, int width, float* output)
+    {
+        const float denom = float(width*(width + 1)*(2*width + 1)/3);
+        const long  last  = long(n_frames) - 1;
+
+        for (size_t r = 0; r < n_rows; r++) {
+            const float* x = &input[r*n_frames];
+            float*       d = &output[r*n_frames];
+            for (long t = 0; t <= last; t++) {
+                float sum = 0.0f;
+                for (int n = 1; n <= width; n++) {
+                    sum += n*(x[std::min(t + n, last)] - x[std::max(t - n, 0L)]);
+                }
+                d[t] = sum/denom;
+            }
+        }
+    }
+
+    const FeatureConfig         m_config;
+    const MelBank               m_mel_bank;
+    const FeatureKernel<float>  m_f4;
+    const FeatureKernel<double> m_f8;
+    const pocketfft::detail::T_dcst23<float> m_dct;
+};
+
+template <>
+inline const FeatureKernel<float>& FeatureExtractor::kernel<float>() const { return m_f4; }
+
+template <>
+inline const FeatureKernel<double>& FeatureExtractor::kernel<double>() const { return m_f8; }
+
+typedef std::shared_ptr<const FeatureExtractor> FeatureHandle;
+
+/***  Class Header  *******************************************************}}}*/
+/**
+* streaming log-mel spectrogram
+* @par description
+*   keep the samples still looked at by the next frames (the overlap tail)
+*   between chunks, so that a push costs O(chunk) and only the frames
+*   completed by the chunk are computed. the window and the FFT plan are
+*   those of the shared feature extractor.
+*   with center, the front is reflect padded as soon as n_fft/2+1 samples
+*   have arrived, and the rear at flush; the frames of the whole stream
+*   are identical to the one-shot log mel spectrogram. the normalizations
+*   relative to the max (:whisper, {:db, top_db}) clamp against the running
+*   max of the frames so far.
+*   the state may be shared between processes, so every access is
+*   serialized by the mutex.
+**/
+/**************************************************************************{{{*/
+class LogMelStream {
+public:
+    LogMelStream(FeatureHandle fe, bool center, const LogMelNorm& norm)
+    : m_fe(fe), m_half(center ? fe->n_fft()/2 : 0), m_norm(norm), m_base(0), m_n_input(0), m_n_frames(0),
+      m_max(-std::numeric_limits<float>::infinity())
+    {
+        m_mutex = enif_mutex_create((char*)"mozu.log_mel_stream");
+    }
+
+    ~LogMelStream() {
+        enif_mutex_destroy(m_mutex);
+    }
+
+    int n_mels() const { return m_fe->n_mels(); }
+
+    // upper bound of the frames for n more input samples (+ flush).
+    size_t max_output(size_t n) const {
+        const size_t total = (m_n_input + n + 2*m_half)/m_fe->hop() + 1;
+        return (total > m_n_frames) ? total - m_n_frames : 0;
+    }
+
+    // consume input[n]; write log mel[n_mels, frames] of the completed frames; return frames.
+    size_t push(const float* input, size_t n, float* output)
+    {
+        m_buffer.insert(m_buffer.end(), input, input + n);
+        m_n_input += n;
+
+        // frame t is complete if it ends inside the input (and the front reflection is known).
+        const size_t n_fft = m_fe->n_fft();
+        size_t last = m_n_frames;
+        if (m_n_input > m_half && m_n_input + m_half >= n_fft) {
+            last = std::max(last, 1 + (m_n_input + m_half - n_fft)/m_fe->hop());
+        }
+
+        return produce(last, output);
+    }
+
+    // the frames over the rear padding; return frames.
+    size_t flush(float* output)
+    {
+        if (m_n_input == 0) {
+            return 0;
+        }
+        return produce(m_fe->n_frames(m_n_input + 2*m_half), output);
+    }
+
+    void lock()   { enif_mutex_lock(m_mutex);   }
+    void unlock() { enif_mutex_unlock(m_mutex); }
+
+protected:
+    size_t produce(size_t last, float* output)
+    {
+        const size_t hop   = m_fe->hop();
+        const size_t n_fft = m_fe->n_fft();
+
+        size_t count = (last > m_n_frames) ? last - m_n_frames : 0;
+        if (count > 0) {
+            // the padded signal of frames [m_n_frames, last): the reflection indices
+            // are those of the whole signal of m_n_input samples.
+            const size_t pos = m_n_frames*hop;
+            m_frames.resize((count - 1)*hop + n_fft);
+            for (size_t k = 0; k < m_frames.size(); k++) {
+                const ptrdiff_t i = _pad_index(ptrdiff_t(pos + k) - ptrdiff_t(m_half), m_n_input, PAD_REFLECT);
+                m_frames[k] = m_buffer[i - m_base];
+            }
+
+            PaddedView<float> view(m_frames.data(), m_frames.size());
+            m_max = std::max(m_max, m_fe->log_mel(view, count, m_norm, output));
+            FeatureExtractor::normalize(output, count*n_mels(), m_norm, m_max, output);
+            m_n_frames = last;
+        }
+
+        // drop the samples before the next frame, but keep n_fft/2+1 at the
+        // rear for its reflection at flush.
+        ptrdiff_t keep = std::min(ptrdiff_t(m_n_frames*hop) - ptrdiff_t(m_half), ptrdiff_t(m_n_input) - ptrdiff_t(m_half) - 1);
+        if (keep > m_base) {
+            m_buffer.erase(m_buffer.begin(), m_buffer.begin() + (keep - m_base));
+            m_base = keep;
+        }
+
+        return count;
+    }
+
+    FeatureHandle      m_fe;
+    size_t             m_half;      // front/rear padding of center
+    LogMelNorm         m_norm;
+    std::vector<float> m_buffer;    // input from sample m_base
+    ptrdiff_t          m_base;
+    size_t             m_n_input;
+    size_t             m_n_frames;  // frames produced
+    float              m_max;       // running max of the log mel
+    std::vector<float> m_frames;    // scratch: padded signal of the new frames
+    ErlNifMutex*       m_mutex;
+};
+
+#endif
+/*** feature.h ***********************************************************}}}*/
@@ -13,108 +13,416 @@
 #include "my_erl_nif.h"
 #include <vector>
 #include <cstring>
+#include <cmath>
 
-#include "pocketfft_hdronly.h"
+#include "npy_utils.h"
+#include "fft.h"
+#include "fft_utils.h"
+#include "fft_plan.h"
+#include "thread_pool.h"
+#include "async_job.h"
 
+// frames per block of the thread pool: a few hundred microseconds at n_fft 400.
+#define RFFT_FRAMES_PER_BLOCK   64
+
+/***  Module Header  ******************************************************}}}*/
+/**
+* real input FFT of 1D wave
+* @par DESCRIPTION
+*   Compute the spectrum of the wave <f4 in dtype by pocketfft or the native
+*   engine (backend :native). oneside returns the N/2+1 bins, otherwise
+*   the negative bins are filled by conjugate symmetry. The power spectrum
+*   :abs/:norm overlays the complex result.
+*
+* @return spectrum
+**/
+/**************************************************************************{{{*/
 template <typename T>
-std::vector<std::complex<T>> _rfft_1D(const std::vector<T>& input)
+ERL_NIF_TERM _rfft_1D_nif(ErlNifEnv* env, ArrayView<const float> wave, const char* power, bool oneside, const char* backend)
 {
-    size_t N = input.size();
-    pocketfft::shape_t shape{N};
-    pocketfft::shape_t axes = {0};
-    pocketfft::stride_t stride_in  = {sizeof(T)};
-    pocketfft::stride_t stride_out = {sizeof(std::complex<T>)};
-    std::vector<std::complex<T>> output(int(N/2)+1);
-    pocketfft::r2c(shape, stride_in, stride_out, axes, pocketfft::FORWARD, input.data(), output.data(), 1.0);
-
-    return output;
+    const size_t N     = wave.size();
+    const size_t count = oneside ? N/2 + 1 : N;
+
+    BinaryArray<std::complex<T>> spectrum;
+    if (!spectrum.alloc(count)) {
+        return enif_make_error(env);
+    }
+
+    if (strcmp(backend, "native") == 0) {
+        // the engine is shared; the scratch is the thread's own.
+        thread_local std::vector<std::complex<T>> work;
+        std::shared_ptr<const RfftEngine<T>> engine = RfftEngine<T>::get(N);
+        work.resize(engine->work_size());
+        engine->forward(wave.data(), spectrum.data(), work.data());
+    }
+    else {
+        std::vector<T> input(wave.begin(), wave.end());
+        _rfft_1D(input.data(), N, spectrum.data());
+    }
+
+    if (!oneside) {
+        // copy positive part to negative part.
+        for (size_t k = N/2 + 1; k < N; k++) {
+            spectrum[k] = std::conj(spectrum[N - k]);
+        }
+    }
+
+    if (strcmp(power, "abs") == 0 || strcmp(power, "norm") == 0) {
+        BinaryArray<T> output;
+        if (strcmp(power, "abs") == 0) {
+            _abs(spectrum.data(), count, reinterpret_cast<T*>(spectrum.data()));   // absolute
+        }
+        else {
+            _norm(spectrum.data(), count, reinterpret_cast<T*>(spectrum.data()));  // norm
+        }
+        spectrum.recast(output);
+        output.shrink(count);
+
+        return enif_make_ok(env, enif_make_array(env, output));
+    }
+
+    return enif_make_ok(env, enif_make_array(env, spectrum));
 }
 
-template <typename T>
-std::vector<T> _abs(const std::vector<std::complex<T>>& input)
-{
-    std::vector<T> absolute;
-    for (const auto& c : input) {
-        absolute.push_back(std::abs(c));
+DECL_NIF(rfft_1D) {
+    ArrayView<const float> wave;
+    std::string dtype;
+    char power[8];
+    bool oneside;
+    char backend[16];
+
+    if (ality != 5
+    || !enif_get_view(env, term[0], wave)
+    || !enif_get_str(env, term[1], dtype)
+    || !enif_get_atom(env, term[2], power, sizeof(power), ERL_NIF_LATIN1)
+    || !enif_get_bool(env, term[3], &oneside)
+    || !enif_get_atom(env, term[4], backend, sizeof(backend), ERL_NIF_LATIN1)
+    || wave.empty()) {
+        return enif_make_badarg(env);
     }
 
-    return absolute;
+    YIELD_TO_DIRTY_CPU(rfft_1D, wave.size()*std::log2(wave.size() + 1));
+
+    return (dtype == "<f4") ? _rfft_1D_nif<float>(env, wave, power, oneside, backend)
+         : (dtype == "<f8") ? _rfft_1D_nif<double>(env, wave, power, oneside, backend)
+         : enif_make_badarg(env);
 }
 
+/***  Module Header  ******************************************************}}}*/
+/**
+* power of spectrum
+* @par DESCRIPTION
+*   Convert complex spectrum <c8/<c16 to absolute/norm <f4/<f8.
+*
+* @return power
+**/
+/**************************************************************************{{{*/
 template <typename T>
-std::vector<T> _norm(const std::vector<std::complex<T>>& input)
+ERL_NIF_TERM _power_nif(ErlNifEnv* env, const ArrayView<const std::complex<T>>& spectrum, bool is_abs)
 {
-    std::vector<T> norm;
-    for (const auto& c : input) {
-        norm.push_back(std::norm(c));
+    BinaryArray<T> output;
+    if (!output.alloc(spectrum.size())) {
+        return enif_make_error(env);
+    }
+
+    if (is_abs) {
+        _abs(spectrum.data(), spectrum.size(), output.data());
+    }
+    else {
+        _norm(spectrum.data(), spectrum.size(), output.data());
+    }
+
+    return enif_make_ok(env, enif_make_array(env, output));
+}
+
+DECL_VALIDATE(power) {
+    ErlNifBinary spectrum;
+    std::string dtype;
+    char mode[8];
+
+    if (ality != 3
+    || !enif_inspect_binary(env, term[0], &spectrum)
+    || !enif_get_str(env, term[1], dtype)
+    || !enif_get_atom(env, term[2], mode, sizeof(mode), ERL_NIF_LATIN1)
+    || (strcmp(mode, "abs") != 0 && strcmp(mode, "norm") != 0)) {
+        return false;
+    }
+    const bool is_abs = (strcmp(mode, "abs") == 0);
+
+    *work = spectrum.size/sizeof(std::complex<float>);
+
+    ArrayView<const std::complex<float>>  c8;
+    ArrayView<const std::complex<double>> c16;
+    if (dtype == "<c8" && enif_get_view(env, term[0], c8)) {
+        compute = [=](ErlNifEnv* env) { return _power_nif<float>(env, c8, is_abs); };
+    }
+    else if (dtype == "<c16" && enif_get_view(env, term[0], c16)) {
+        compute = [=](ErlNifEnv* env) { return _power_nif<double>(env, c16, is_abs); };
     }
 
-    return norm;
+    return bool(compute);
+}
+
+DECL_NIF(power) {
+    AsyncCompute compute;
+    double work;
+
+    if (!power_validate(env, ality, term, compute, &work)) {
+        return enif_make_badarg(env);
+    }
+
+    YIELD_TO_DIRTY_CPU(power, work);
+
+    return compute(env);
 }
 
 /***  Module Header  ******************************************************}}}*/
 /**
-* 
+* real input FFT over the rows of matrix
 * @par DESCRIPTION
-*   
+*   Compute the one-sided spectrum of every frame in matrix[n_frames, n_fft]
+*   by strided pocketfft calls over frame blocks, shared out to the thread
+*   pool. nthreads caps the number of blocks and so the threads working on
+*   them: 0 for the whole pool, 1 for the calling thread alone. The power
+*   spectrum is taken by the same blocks.
+*   With hop < n_fft the input is the strided frame view of a signal: frame t
+*   starts at sample t*hop, and the overlapping frames are never copied.
+*   center reflect pads the signal by n_fft/2 virtually; only the boundary
+*   frames are assembled, the others are read from the signal in place.
 *
-* @return
+* @return matrix[n_frames, n_fft/2+1]
 **/
 /**************************************************************************{{{*/
-DECL_NIF(rfft_1D) {
-    std::vector<double> wave_as_double;
-    char power[8];
-    bool oneside;
+template <typename T>
+ERL_NIF_TERM _rfft_2D_nif(ErlNifEnv* env, const ErlNifBinary& frames, size_t n_fft, size_t hop, bool center, const char* power, size_t nthreads)
+{
+    const T* wave = reinterpret_cast<const T*>(frames.data);
+    const size_t n_freq = n_fft/2 + 1;
 
-    if (ality != 3
-    || !enif_get_vector_as<float, double>(env, term[0], wave_as_double)
-    || !enif_get_atom(env, term[1], power, sizeof(power), ERL_NIF_LATIN1)
-    || !enif_get_bool(env, term[2], &oneside)) {
-        return enif_make_badarg(env);
+    // center: the wave is reflect padded by n_fft/2 virtually.
+    const size_t half = center ? n_fft/2 : 0;
+    PaddedView<T> padded(wave, frames.size/sizeof(T), half, half, PAD_REFLECT);
+
+    const size_t size     = padded.size();
+    const size_t n_frames = (size >= n_fft) ? 1 + (size - n_fft)/hop : 0;
+    const size_t count    = n_frames*n_freq;
+
+    BinaryArray<std::complex<T>> spectrum;
+    if (!spectrum.alloc(count)) {
+        return enif_make_error(env);
     }
 
-    auto spectrum = _rfft_1D(wave_as_double);
+    // frames [first, last) lie inside the wave and go through one strided call.
+    size_t first = std::min((half + hop - 1)/hop, n_frames);
+    size_t last  = first;
+    while (last < n_frames && padded.inside(last*hop, n_fft)) {
+        last++;
+    }
+    // no more than nthreads blocks of frames, so as many threads at most.
+    auto grain = [nthreads](size_t count) {
+        return (nthreads == 0) ? size_t(RFFT_FRAMES_PER_BLOCK)
+             : std::max(size_t(RFFT_FRAMES_PER_BLOCK), (count + nthreads - 1)/nthreads);
+    };
+    parallel_for(last - first, grain(last - first), [&](size_t begin, size_t end) {
+        _rfft_2D(padded.at((first + begin)*hop), end - begin, n_fft, hop, &spectrum[(first + begin)*n_freq]);
+    });
 
-    if (!oneside) {
-        // copy positive part to negative part.
-        size_t N = wave_as_double.size();
-        spectrum.resize(N);     // make room for negative part.
+    // the few boundary frames are assembled from the virtual padding.
+    std::vector<T> edge(n_fft);
+    auto boundary = [&](size_t t) {
+        padded.copy(t*hop, n_fft, edge.data());
+        _rfft_2D(edge.data(), 1, n_fft, &spectrum[t*n_freq]);
+    };
+    for (size_t t = 0; t < first; t++) {
+        boundary(t);
+    }
+    for (size_t t = last; t < n_frames; t++) {
+        boundary(t);
+    }
 
-        auto src = spectrum.begin() + (int(N/2)-1);
-        auto dst = spectrum.begin() + (int(N/2)+1);
-        while (dst < spectrum.end()) {
-            *dst++ = std::conj(*src--);
+    if (strcmp(power, "abs") == 0 || strcmp(power, "norm") == 0) {
+        // the blocks run in parallel, so the power cannot overlay the complex
+        // rows still to be read by the others.
+        BinaryArray<T> output;
+        if (!output.alloc(count)) {
+            return enif_make_error(env);
         }
+
+        const bool is_abs = (strcmp(power, "abs") == 0);
+        parallel_for(n_frames, grain(n_frames), [&](size_t begin, size_t end) {
+            if (is_abs) {
+                _abs(&spectrum[begin*n_freq], (end - begin)*n_freq, &output[begin*n_freq]);
+            }
+            else {
+                _norm(&spectrum[begin*n_freq], (end - begin)*n_freq, &output[begin*n_freq]);
+            }
+        });
+
+        return enif_make_ok(env, enif_make_array(env, output));
+    }
+
+    return enif_make_ok(env, enif_make_array(env, spectrum));
+}
+
+DECL_VALIDATE(rfft_2D) {
+    ErlNifBinary frames;
+    std::string dtype;
+    unsigned int n_fft;
+    unsigned int hop;
+    bool center;
+    char power[8];
+    unsigned int nthreads;
+
+    if (ality != 7
+    || !enif_inspect_binary(env, term[0], &frames)
+    || !enif_align_binary(env, frames, alignof(double))
+    || !enif_get_str(env, term[1], dtype)
+    || !enif_get_uint(env, term[2], &n_fft)
+    || !enif_get_uint(env, term[3], &hop)
+    || !enif_get_bool(env, term[4], &center)
+    || !enif_get_atom(env, term[5], power, sizeof(power), ERL_NIF_LATIN1)
+    || !enif_get_uint(env, term[6], &nthreads)
+    || n_fft == 0 || hop == 0 || frames.size == 0) {
+        return false;
+    }
+
+    // the matrix of frames (hop == n_fft without center) has whole rows.
+    const size_t unit = (dtype == "<f4") ? sizeof(float) : (dtype == "<f8") ? sizeof(double) : 0;
+    if (unit == 0
+    || frames.size % unit != 0
+    || (hop == n_fft && !center && frames.size % (n_fft*unit) != 0)) {
+        return false;
     }
 
-    ERL_NIF_TERM output = (strcmp(power, "abs")  == 0) ? enif_make_vector(env, _abs(spectrum))  // absolute
-                        : (strcmp(power, "norm") == 0) ? enif_make_vector(env, _norm(spectrum)) // norm
-                        : enif_make_vector(env, std::move(spectrum));
+    *work = frames.size/hop*n_fft*std::log2(n_fft + 1);
 
-    return enif_make_ok(env, output);
+    if (dtype == "<f4") {
+        compute = [=](ErlNifEnv* env) { return _rfft_2D_nif<float>(env, frames, n_fft, hop, center, power, nthreads); };
+    }
+    else {
+        compute = [=](ErlNifEnv* env) { return _rfft_2D_nif<double>(env, frames, n_fft, hop, center, power, nthreads); };
+    }
+
+    return true;
+}
+
+DECL_NIF(rfft_2D) {
+    AsyncCompute compute;
+    double work;
+
+    if (!rfft_2D_validate(env, ality, term, compute, &work)) {
+        return enif_make_badarg(env);
+    }
+
+    YIELD_TO_DIRTY_CPU(rfft_2D, work);
+
+    return compute(env);
 }
 
 /***  Module Header  ******************************************************}}}*/
 /**
-* 
+* create FFT plan
 * @par DESCRIPTION
-*   
+*   Create the reusable real input FFT plan of size n_fft computing in dtype
+*   "<f4" or "<f8".
 *
-* @return
+* @return {:ok, plan}
 **/
 /**************************************************************************{{{*/
-DECL_NIF(power) {
-    std::vector<std::complex<double>> spectrum;
-    char power[8];
+DECL_NIF(fft_plan) {
+    unsigned int n_fft;
+    std::string dtype;
 
     if (ality != 2
-    || !enif_get_vector(env, term[0], spectrum)
-    || !enif_get_atom(env, term[1], power, sizeof(power), ERL_NIF_LATIN1)) {
+    || !enif_get_uint(env, term[0], &n_fft)
+    || !enif_get_str(env, term[1], dtype)
+    || n_fft == 0) {
+        return enif_make_badarg(env);
+    }
+
+    return (dtype == "<f4") ? Resource<FftPlan<float>>::make_resource(env, new FftPlan<float>(n_fft))
+         : (dtype == "<f8") ? Resource<FftPlan<double>>::make_resource(env, new FftPlan<double>(n_fft))
+         : enif_make_badarg(env);
+}
+
+/***  Module Header  ******************************************************}}}*/
+/**
+* real input FFT with plan
+* @par DESCRIPTION
+*   Compute the one-sided spectrum of every frame in matrix[n_frames, n_fft]
+*   through the plan. The spectrum is written straight into the result, so
+*   no intermediate buffer is allocated per frame. The plan is shared without
+*   a lock, so the frame blocks go to the thread pool as in rfft_2D.
+*   The input dtype must be the one of the plan, and the result keeps it.
+*
+* @return matrix[n_frames, n_fft/2+1]
+**/
+/**************************************************************************{{{*/
+template <typename T>
+ERL_NIF_TERM _rfft_plan_nif(ErlNifEnv* env, ERL_NIF_TERM ref, const ErlNifBinary& frames, const char* power)
+{
+    FftPlan<T>* plan;
+    if (!Resource<FftPlan<T>>::get_item(env, ref, &plan)) {
+        return enif_make_badarg(env);
+    }
+
+    const size_t n_fft  = plan->size();
+    const size_t n_freq = plan->n_freq();
+    if (frames.size % (n_fft*sizeof(T)) != 0) {
         return enif_make_badarg(env);
     }
+    const size_t n_frames = frames.size / (n_fft*sizeof(T));
+    const size_t count    = n_frames*n_freq;
+
+    BinaryArray<std::complex<T>> spectrum;
+    if (!spectrum.alloc(count)) {
+        return enif_make_error(env);
+    }
+
+    const T* src = reinterpret_cast<const T*>(frames.data);
+    parallel_for(n_frames, RFFT_FRAMES_PER_BLOCK, [&](size_t begin, size_t end) {
+        for (size_t t = begin; t < end; t++) {
+            plan->rfft(&src[t*n_fft], &spectrum[t*n_freq]);
+        }
+    });
+
+    if (strcmp(power, "abs") == 0 || strcmp(power, "norm") == 0) {
+        BinaryArray<T> output;
+        if (strcmp(power, "abs") == 0) {
+            _abs(spectrum.data(), count, reinterpret_cast<T*>(spectrum.data()));   // absolute
+        }
+        else {
+            _norm(spectrum.data(), count, reinterpret_cast<T*>(spectrum.data()));  // norm
+        }
+        spectrum.recast(output);
+        output.shrink(count);
+
+        return enif_make_ok(env, enif_make_array(env, output));
+    }
+
+    return enif_make_ok(env, enif_make_array(env, spectrum));
+}
+
+DECL_NIF(rfft_plan) {
+    ErlNifBinary frames;
+    std::string dtype;
+    char power[8];
+
+    if (ality != 4
+    || !enif_inspect_binary(env, term[1], &frames)
+    || !enif_get_str(env, term[2], dtype)
+    || !enif_get_atom(env, term[3], power, sizeof(power), ERL_NIF_LATIN1)) {
+        return enif_make_badarg(env);
+    }
+
+    YIELD_TO_DIRTY_CPU(rfft_plan, frames.size*std::log2(frames.size + 1));
+
+    if (!enif_align_binary(env, frames, alignof(double))) {
+        return enif_make_error(env);
+    }
 
-    return (strcmp(power, "abs")  == 0) ? enif_make_ok(env, enif_make_vector(env, _abs(spectrum)))
-         : (strcmp(power, "norm") == 0) ? enif_make_ok(env, enif_make_vector(env, _norm(spectrum)))
+    return (dtype == "<f4") ? _rfft_plan_nif<float>(env, term[0], frames, power)
+         : (dtype == "<f8") ? _rfft_plan_nif<double>(env, term[0], frames, power)
          : enif_make_badarg(env);
 }
 
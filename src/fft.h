@@ -2,7 +2,7 @@
 /**
 * @file fft.h
 *   Fast Fourier transform
-* 
+*
 * @author	Shozo Fukuda
 * @date	    create 2024-04-16 10:05:17
 * System	Windows10<br>
@@ -13,92 +13,396 @@
 #define _FFT_H
 
 #include <vector>
+#include <complex>
+#include <memory>
+#include <map>
+#include <mutex>
+#include <algorithm>
+#include <cstdint>
 #include <cmath>
 
-/***  Module Header  ******************************************************}}}*/
+/***  Class Header  *******************************************************}}}*/
 /**
-* Discrete Fourier transform
-* @par DESCRIPTION
-*   Convert signal to spectrum.
-*
-* @retval spectrum (complex)
+* complex FFT engine
+* @par description
+*   iterative Stockham FFT of fixed size N. N is factored into radix 4/2/3/5
+*   stages whose twiddle factors are computed at construction; a size with
+*   any other prime factor is transformed by Bluestein's chirp-z algorithm
+*   over a power of two engine.
+*   the engine is immutable once built: forward() works in the caller's
+*   buffer of work_size() elements, so one engine is shared by any number
+*   of threads.
 **/
 /**************************************************************************{{{*/
 template <typename T>
-std::vector<T> dft(const std::vector<T> &input) {
-    std::vector<T> output;
+class FftEngine {
+public:
+    typedef std::complex<T> Complex;
+
+    explicit FftEngine(size_t n) : m_n(n)
+    {
+        size_t rest = n;
+        for (size_t radix : {4, 2, 3, 5}) {
+            while (rest % radix == 0) {
+                m_radix.push_back(radix);
+                rest /= radix;
+            }
+        }
+
+        if (rest == 1) {
+            make_twiddle();
+        }
+        else {
+            make_bluestein();
+        }
+    }
 
-    int N = input.size();
+    size_t size() const { return m_n; }
 
-    for (int k = 0; k < N; k++) {
-        T re = 0;
-        T im = 0;
+    // elements of the work buffer of forward().
+    size_t work_size() const
+    {
+        return m_conv ? m_conv->size() + m_conv->work_size() : m_n;
+    }
 
-        for (int n = 0; n < N; n++) {
-            T theta = 2*M_PI * k/N * n;
-            re += input[n] * cos(theta);
-            im -= input[n] * sin(theta);
+    // in place forward transform of data[N], work[work_size()] the scratch.
+    void forward(Complex* data, Complex* work) const
+    {
+        if (m_conv) {
+            bluestein(data, work);
         }
+        else {
+            stockham(data, work);
+        }
+    }
 
-        output.push_back(re);
-        output.push_back(im);
+protected:
+    // twiddle of stage s: w^(r*k) for k < Ns (product of the former radices), 1 <= r < radix.
+    void make_twiddle()
+    {
+        size_t ns = 1;
+        for (size_t radix : m_radix) {
+            m_offset.push_back(m_twiddle.size());
+            for (size_t k = 0; k < ns; k++) {
+                for (size_t r = 1; r < radix; r++) {
+                    m_twiddle.push_back(polar(-double(r*k)/double(ns*radix)));
+                }
+            }
+            ns *= radix;
+        }
     }
 
-    return output;
-}
+    void stockham(Complex* data, Complex* work) const
+    {
+        Complex* src = data;
+        Complex* dst = work;
 
-/***  Module Header  ******************************************************}}}*/
+        size_t ns = 1;
+        for (size_t s = 0; s < m_radix.size(); s++) {
+            const size_t  radix = m_radix[s];
+            const size_t  m     = m_n / radix;
+            const Complex* tw   = &m_twiddle[m_offset[s]];
+
+            switch (radix) {
+            case 2: pass<butterfly2>(src, dst, tw, m, ns, 2); break;
+            case 3: pass<butterfly3>(src, dst, tw, m, ns, 3); break;
+            case 4: pass<butterfly4>(src, dst, tw, m, ns, 4); break;
+            case 5: pass<butterfly5>(src, dst, tw, m, ns, 5); break;
+            }
+
+            std::swap(src, dst);
+            ns *= radix;
+        }
+
+        if (src != data) {
+            std::copy(src, src + m_n, data);
+        }
+    }
+
+    typedef void (*Butterfly)(const Complex*, size_t, const Complex*, Complex*, size_t);
+
+    // one stage: j = b*Ns + k runs over the m sub-transforms of size radix.
+    template <Butterfly butterfly>
+    static void pass(const Complex* src, Complex* dst, const Complex* tw, size_t m, size_t ns, size_t radix)
+    {
+        for (size_t b = 0; b < m; b += ns) {
+            const Complex* in  = &src[b];
+            Complex*       out = &dst[b*radix];
+            for (size_t k = 0; k < ns; k++) {
+                butterfly(&in[k], m, &tw[k*(radix - 1)], &out[k], ns);
+            }
+        }
+    }
+
+    static void butterfly2(const Complex* in, size_t m, const Complex* w, Complex* out, size_t ns)
+    {
+        Complex v0 = in[0];
+        Complex v1 = mul(in[m], w[0]);
+        out[0]    = v0 + v1;
+        out[ns]   = v0 - v1;
+    }
+
+    static void butterfly3(const Complex* in, size_t m, const Complex* w, Complex* out, size_t ns)
+    {
+        const T sin60 = T(0.86602540378443864676);
+
+        Complex v0 = in[0];
+        Complex v1 = mul(in[m], w[0]);
+        Complex v2 = mul(in[2*m], w[1]);
+
+        Complex t1 = v1 + v2;
+        Complex t2 = v0 - T(0.5)*t1;
+        Complex t3 = mul_i(v1 - v2)*(-sin60);
+        out[0]    = v0 + t1;
+        out[ns]   = t2 + t3;
+        out[2*ns] = t2 - t3;
+    }
+
+    static void butterfly4(const Complex* in, size_t m, const Complex* w, Complex* out, size_t ns)
+    {
+        Complex v0 = in[0];
+        Complex v1 = mul(in[m], w[0]);
+        Complex v2 = mul(in[2*m], w[1]);
+        Complex v3 = mul(in[3*m], w[2]);
+
+        Complex a0 = v0 + v2;
+        Complex a1 = v0 - v2;
+        Complex a2 = v1 + v3;
+        Complex a3 = -mul_i(v1 - v3);
+        out[0]    = a0 + a2;
+        out[ns]   = a1 + a3;
+        out[2*ns] = a0 - a2;
+        out[3*ns] = a1 - a3;
+    }
+
+    static void butterfly5(const Complex* in, size_t m, const Complex* w, Complex* out, size_t ns)
+    {
+        const T c1 = T( 0.30901699437494742410);     // cos(2pi/5)
+        const T c2 = T(-0.80901699437494742410);     // cos(4pi/5)
+        const T s1 = T( 0.95105651629515357212);     // sin(2pi/5)
+        const T s2 = T( 0.58778525229247312917);     // sin(4pi/5)
+
+        Complex v0 = in[0];
+        Complex v1 = mul(in[m], w[0]);
+        Complex v2 = mul(in[2*m], w[1]);
+        Complex v3 = mul(in[3*m], w[2]);
+        Complex v4 = mul(in[4*m], w[3]);
+
+        Complex a1 = v1 + v4, b1 = v1 - v4;
+        Complex a2 = v2 + v3, b2 = v2 - v3;
+
+        Complex p1 = v0 + c1*a1 + c2*a2;
+        Complex p2 = v0 + c2*a1 + c1*a2;
+        Complex q1 = mul_i(s1*b1 + s2*b2);
+        Complex q2 = mul_i(s2*b1 - s1*b2);
+        out[0]    = v0 + a1 + a2;
+        out[ns]   = p1 - q1;
+        out[2*ns] = p2 - q2;
+        out[3*ns] = p2 + q2;
+        out[4*ns] = p1 + q1;
+    }
+
+    // Bluestein: X[k] = w[k] * sum_n (x[n] w[n]) conj(w[k-n]), w[n] = exp(-i pi n^2/N)
+    void make_bluestein()
+    {
+        size_t m = 1;
+        while (m < 2*m_n - 1) {
+            m <<= 1;
+        }
+        m_conv.reset(new FftEngine<T>(m));
+
+        m_chirp.resize(m_n);
+        for (size_t i = 0; i < m_n; i++) {
+            // i^2 mod 2N keeps the phase exact for large N.
+            unsigned long long sq = (unsigned long long)i*i % (2*m_n);
+            m_chirp[i] = polar(-double(sq)/double(2*m_n));
+        }
+
+        m_kernel.assign(m, Complex(0));
+        m_kernel[0] = std::conj(m_chirp[0]);
+        for (size_t i = 1; i < m_n; i++) {
+            m_kernel[i] = m_kernel[m - i] = std::conj(m_chirp[i]);
+        }
+        std::vector<Complex> work(m_conv->work_size());
+        m_conv->forward(m_kernel.data(), work.data());
+
+        // fold the 1/M of the inverse transform into the kernel.
+        for (auto& c : m_kernel) {
+            c /= T(m);
+        }
+    }
+
+    // work: the convolution buffer[M], then the scratch of the M engine.
+    void bluestein(Complex* data, Complex* work) const
+    {
+        const size_t m    = m_conv->size();
+        Complex*     conv = work;
+
+        for (size_t i = 0; i < m_n; i++) {
+            conv[i] = mul(data[i], m_chirp[i]);
+        }
+        std::fill(conv + m_n, conv + m, Complex(0));
+
+        m_conv->forward(conv, work + m);
+        for (size_t i = 0; i < m; i++) {
+            conv[i] = std::conj(mul(conv[i], m_kernel[i]));
+        }
+        // inverse by the forward transform of the conjugate.
+        m_conv->forward(conv, work + m);
+
+        for (size_t i = 0; i < m_n; i++) {
+            data[i] = mul(std::conj(conv[i]), m_chirp[i]);
+        }
+    }
+
+    static Complex polar(double turn)
+    {
+        return Complex(T(std::cos(2*M_PI*turn)), T(std::sin(2*M_PI*turn)));
+    }
+
+    static Complex mul_i(const Complex& c)
+    {
+        return Complex(-c.imag(), c.real());
+    }
+
+public:
+    // plain complex product, without the inf/nan recovery of operator*.
+    static Complex mul(const Complex& a, const Complex& b)
+    {
+        return Complex(a.real()*b.real() - a.imag()*b.imag(), a.real()*b.imag() + a.imag()*b.real());
+    }
+
+protected:
+    size_t                       m_n;
+    std::vector<size_t>          m_radix;
+    std::vector<size_t>          m_offset;
+    std::vector<Complex>         m_twiddle;
+
+    std::unique_ptr<FftEngine<T>> m_conv;
+    std::vector<Complex>         m_chirp;
+    std::vector<Complex>         m_kernel;
+};
+
+/***  Class Header  *******************************************************}}}*/
 /**
-* Fast Fourier transform
-* @par DESCRIPTION
-*   Convert signal to spectrum.
-*
-* @retval spectrum (complex)
+* real input FFT engine
+* @par description
+*   one-sided spectrum of real signal of size N. an even N is packed into
+*   the complex signal of N/2 and split after the transform; an odd N is
+*   transformed at full length.
+*   the engines are immutable and cached per type and size by get(), so
+*   the twiddles and the Bluestein chirp are computed once per size.
 **/
 /**************************************************************************{{{*/
 template <typename T>
-std::vector<T> fft(const std::vector<T> &input) {
-    int N = input.size();
-
-    if (N == 1) {
-        std::vector<T> output = {input[0], 0};
-        return output;
-    }
-    else if (N % 2 == 1) {
-        return dft(input);
-    }
-    else {
-        std::vector<T> even;
-        std::vector<T> odd;
-        for (int i = 0; i < N; i++) {
-            if (i % 2 == 0) {
-                even.push_back(input[i]);
-            } else {
-                odd.push_back(input[i]);
+class RfftEngine {
+public:
+    typedef std::complex<T> Complex;
+
+    explicit RfftEngine(size_t n)
+    : m_n(n), m_fft((n % 2 == 0) ? n/2 : n)
+    {
+        if (n % 2 == 0) {
+            m_twiddle.resize(n/2 + 1);
+            for (size_t k = 0; k <= n/2; k++) {
+                double theta = -2*M_PI*double(k)/double(n);
+                m_twiddle[k] = Complex(T(std::cos(theta)), T(std::sin(theta)));
             }
         }
+    }
+
+    static std::shared_ptr<const RfftEngine> get(size_t n);
 
-        std::vector<T> evenFFT = fft(even);
-        std::vector<T> oddFFT  = fft(odd);
+    size_t size()   const { return m_n; }
+    size_t n_freq() const { return m_n/2 + 1; }
 
-        std::vector<T> output(2*N);
-        for (int k = 0; k < N/2; k++) {
-            T theta = 2*M_PI * k/N;
-            T re =  cos(theta);
-            T im = -sin(theta);
+    // elements of the work buffer of forward().
+    size_t work_size() const { return m_fft.size() + m_fft.work_size(); }
 
-            T reOdd = oddFFT[2*k + 0];
-            T imOdd = oddFFT[2*k + 1];
+    // one-sided spectrum of input[N] into output[N/2+1], work[work_size()] the scratch.
+    template <typename U>
+    void forward(const U* input, Complex* output, Complex* work) const
+    {
+        Complex* buffer = work;
 
-            output[0 + 2*k + 0] = evenFFT[2*k + 0] + re*reOdd - im*imOdd;
-            output[0 + 2*k + 1] = evenFFT[2*k + 1] + re*imOdd + im*reOdd;
+        if (m_n % 2 != 0) {
+            for (size_t i = 0; i < m_n; i++) {
+                buffer[i] = Complex(T(input[i]), 0);
+            }
+            m_fft.forward(buffer, work + m_fft.size());
+            std::copy(buffer, buffer + n_freq(), output);
+            return;
+        }
 
-            output[N + 2*k + 0] = evenFFT[2*k + 0] - re*reOdd + im*imOdd;
-            output[N + 2*k + 1] = evenFFT[2*k + 1] - re*imOdd - im*reOdd;
+        const size_t h = m_n/2;
+        for (size_t i = 0; i < h; i++) {
+            buffer[i] = Complex(T(input[2*i]), T(input[2*i+1]));
         }
+        m_fft.forward(buffer, work + m_fft.size());
 
-        return output;
+        // even/odd part: E[k] = (Z[k] + conj(Z[h-k]))/2, O[k] = -i(Z[k] - conj(Z[h-k]))/2
+        const Complex z0 = buffer[0];
+        output[0] = Complex(z0.real() + z0.imag(), 0);
+        output[h] = Complex(z0.real() - z0.imag(), 0);
+        for (size_t k = 1; k < h; k++) {
+            const Complex z  = buffer[k];
+            const Complex zc = std::conj(buffer[h - k]);
+            const Complex e  = T(0.5)*(z + zc);
+            const Complex d  = T(0.5)*(z - zc);
+            const Complex o  = Complex(d.imag(), -d.real());
+            output[k] = e + FftEngine<T>::mul(m_twiddle[k], o);
+        }
     }
+
+protected:
+    size_t               m_n;
+    FftEngine<T>         m_fft;
+    std::vector<Complex> m_twiddle;
+};
+
+/***  Module Header  ******************************************************}}}*/
+/**
+* real input FFT engine cache
+* @par DESCRIPTION
+*   Return the shared engine of size n, built at the first request. When
+*   the cache is full, the least recently used engine is dropped; the
+*   callers still transforming keep it alive.
+*
+* @retval engine
+**/
+/**************************************************************************{{{*/
+#define RFFT_ENGINE_CACHE_SIZE  16
+
+template <typename T>
+std::shared_ptr<const RfftEngine<T>> RfftEngine<T>::get(size_t n)
+{
+    struct Entry {
+        std::shared_ptr<const RfftEngine> engine;
+        uint64_t                          used;
+    };
+    static std::mutex mutex;
+    static std::map<size_t, Entry> cache;
+    static uint64_t clock = 0;
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto found = cache.find(n);
+    if (found != cache.end()) {
+        found->second.used = ++clock;
+        return found->second.engine;
+    }
+
+    if (cache.size() >= RFFT_ENGINE_CACHE_SIZE) {
+        auto lru = std::min_element(cache.begin(), cache.end(), [](const auto& a, const auto& b) {
+            return a.second.used < b.second.used;
+        });
+        cache.erase(lru);
+    }
+
+    std::shared_ptr<const RfftEngine> engine = std::make_shared<const RfftEngine>(n);
+    cache.emplace(n, Entry{engine, ++clock});
+
+    return engine;
 }
 
 #endif
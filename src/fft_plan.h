@@ -0,0 +1,87 @@
+/***  File Header  ************************************************************/
+/**
+* fft_plan.h
+*
+* Elixir/Erlang Port ext. of Post-processing for DNN.
+* @author   Shozo Fukuda
+* @date     create 2026-10-17 15:02:26
+* System    Windows10, WSL2/Ubuntu 20.04.2<br>
+*
+**/
+/**************************************************************************{{{*/
+#ifndef _FFT_PLAN_H
+#define _FFT_PLAN_H
+
+#include "my_erl_nif.h"
+#include <complex>
+#include <memory>
+#include <cstdint>
+
+#include "pocketfft_hdronly.h"
+
+/***  Class Header  *******************************************************}}}*/
+/**
+* real input FFT plan
+* @par description
+*   keep the pocketfft plan of the fixed size, so that repeated transforms
+*   skip the plan lookup. the plan is immutable and shared by the callers
+*   without a lock; each thread transforms in its own aligned scratch, which
+*   is allocated once and grows to the largest plan it has run.
+**/
+/**************************************************************************{{{*/
+template <typename T>
+class FftPlan {
+public:
+    static const size_t ALIGNMENT = 64;
+
+    FftPlan(size_t n) : m_n(n), m_plan(n) {}
+
+    size_t size()   const { return m_n; }
+    size_t n_freq() const { return m_n/2 + 1; }
+
+    // one-sided spectrum of input[n] into output[n/2+1].
+    template <typename U>
+    void rfft(const U* input, std::complex<T>* output) const
+    {
+        T* work = scratch(m_n);
+
+        for (size_t i = 0; i < m_n; i++) {
+            work[i] = T(input[i]);
+        }
+
+        // halfcomplex: r0, r1, i1, r2, i2, ... (, r[n/2] if n is even)
+        m_plan.exec(work, T(1.0), true);
+
+        output[0] = std::complex<T>(work[0], 0);
+        for (size_t k = 1; k < (m_n+1)/2; k++) {
+            output[k] = std::complex<T>(work[2*k-1], work[2*k]);
+        }
+        if (m_n % 2 == 0) {
+            output[m_n/2] = std::complex<T>(work[m_n-1], 0);
+        }
+    }
+
+protected:
+    // aligned scratch of the calling thread, n elements at least.
+    static T* scratch(size_t n)
+    {
+        thread_local std::unique_ptr<char[]> storage;
+        thread_local size_t                  capacity = 0;
+        thread_local T*                      aligned  = nullptr;
+
+        if (capacity < n) {
+            storage.reset(new char[n*sizeof(T) + ALIGNMENT]);
+            capacity = n;
+
+            uintptr_t addr = reinterpret_cast<uintptr_t>(storage.get());
+            aligned = reinterpret_cast<T*>((addr + ALIGNMENT - 1) & ~uintptr_t(ALIGNMENT - 1));
+        }
+        return aligned;
+    }
+
+    size_t                                m_n;
+    pocketfft::detail::pocketfft_r<T>     m_plan;
+};
+
+#endif
+/*** fft_plan.h **********************************************************}}}*/
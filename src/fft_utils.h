@@ -0,0 +1,129 @@
+/***  File Header  ************************************************************/
+/**
+* @file fft_utils.h
+*
+* 
+* @author	Shozo Fukuda
+* @date	    create 2024-04-16 17:17:19
+* System	Windows10 <br>
+*
+**/
+/**************************************************************************{{{*/
+#ifndef _FFT_UTILS_H
+#define _FFT_UTILS_H
+
+#include <vector>
+#include <complex>
+
+#include "pocketfft_hdronly.h"
+#include "simd.h"
+
+/***  Module Header  ******************************************************}}}*/
+/**
+* real input FFT
+* @par DESCRIPTION
+*   Compute the one-sided spectrum of real signal by pocketfft.
+*   The pointer version writes N/2+1 bins into the caller's buffer.
+*
+* @retval spectrum (complex)
+**/
+/**************************************************************************{{{*/
+template <typename T>
+void _rfft_1D(const T* input, size_t N, std::complex<T>* output)
+{
+    pocketfft::shape_t shape{N};
+    pocketfft::shape_t axes = {0};
+    pocketfft::stride_t stride_in  = {sizeof(T)};
+    pocketfft::stride_t stride_out = {sizeof(std::complex<T>)};
+    pocketfft::r2c(shape, stride_in, stride_out, axes, pocketfft::FORWARD, input, output, T(1.0));
+}
+
+template <typename T>
+std::vector<std::complex<T>> _rfft_1D(const std::vector<T>& input)
+{
+    size_t N = input.size();
+    std::vector<std::complex<T>> output(int(N/2)+1);
+    _rfft_1D(input.data(), N, output.data());
+
+    return output;
+}
+
+/***  Module Header  ******************************************************}}}*/
+/**
+* real input FFT over rows
+* @par DESCRIPTION
+*   Transform every row of the matrix[n_rows, N] in one pocketfft call,
+*   using its multi-dimensional shape/stride support and worker threads.
+*   Row i starts at input[i*hop]; hop < N reads overlapping frames straight
+*   from the signal without materializing them.
+*
+* @retval matrix[n_rows, N/2+1] (complex)
+**/
+/**************************************************************************{{{*/
+template <typename T>
+void _rfft_2D(const T* input, size_t n_rows, size_t N, size_t hop, std::complex<T>* output, size_t nthreads=1)
+{
+    pocketfft::shape_t shape{n_rows, N};
+    pocketfft::shape_t axes = {1};
+    pocketfft::stride_t stride_in  = {ptrdiff_t(hop*sizeof(T)), sizeof(T)};
+    pocketfft::stride_t stride_out = {ptrdiff_t((N/2+1)*sizeof(std::complex<T>)), sizeof(std::complex<T>)};
+    pocketfft::r2c(shape, stride_in, stride_out, axes, pocketfft::FORWARD, input, output, T(1.0), nthreads);
+}
+
+template <typename T>
+void _rfft_2D(const T* input, size_t n_rows, size_t N, std::complex<T>* output, size_t nthreads=1)
+{
+    _rfft_2D(input, n_rows, N, N, output, nthreads);
+}
+
+/***  Module Header  ******************************************************}}}*/
+/**
+* power of spectrum
+* @par DESCRIPTION
+*   Convert complex spectrum to absolute/norm.
+*
+* @retval power
+**/
+/**************************************************************************{{{*/
+// pointer versions may be applied in place (output == input).
+// they run on the SIMD kernels selected at load.
+inline void _abs(const std::complex<float>* input, size_t count, float* output)
+{
+    simd().abs_f4(reinterpret_cast<const float*>(input), count, output);
+}
+
+inline void _abs(const std::complex<double>* input, size_t count, double* output)
+{
+    simd().abs_f8(reinterpret_cast<const double*>(input), count, output);
+}
+
+inline void _norm(const std::complex<float>* input, size_t count, float* output)
+{
+    simd().norm_f4(reinterpret_cast<const float*>(input), count, output);
+}
+
+inline void _norm(const std::complex<double>* input, size_t count, double* output)
+{
+    simd().norm_f8(reinterpret_cast<const double*>(input), count, output);
+}
+
+template <typename T>
+std::vector<T> _abs(const std::vector<std::complex<T>>& input)
+{
+    std::vector<T> absolute(input.size());
+    _abs(input.data(), input.size(), absolute.data());
+
+    return absolute;
+}
+
+template <typename T>
+std::vector<T> _norm(const std::vector<std::complex<T>>& input)
+{
+    std::vector<T> norm(input.size());
+    _norm(input.data(), input.size(), norm.data());
+
+    return norm;
+}
+
+#endif
+/*** fft_utils.h *********************************************************}}}*/
@@ -11,38 +11,13 @@
 /**************************************************************************{{{*/
 
 #include "my_erl_nif.h"
-#include "npy_utils.h"
-#include <cmath>
-#include <functional>
+#include "filter_bank.h"
+#include "thread_pool.h"
+#include "async_job.h"
 #include <vector>
-#include <cassert>
 
-enum MelScale {
-    NONE = 0,
-    HTK,
-    KALDI,
-    SLANEY
-};
-
-bool enif_get_mel_scale(ErlNifEnv* env, ERL_NIF_TERM term, int* mel_scale)
-{
-    char mel_scale_name[16];
-    int len;
-
-    if ((len = enif_get_atom(env, term, mel_scale_name, sizeof(mel_scale_name), ERL_NIF_LATIN1)) == 0) {
-        return false;
-    }
-
-    *mel_scale = (std::strcmp(mel_scale_name, "htk"   ) == 0) ? HTK
-               : (std::strcmp(mel_scale_name, "kaldi" ) == 0) ? KALDI
-               : (std::strcmp(mel_scale_name, "slaney") == 0) ? SLANEY
-               : NONE;
-
-    return (*mel_scale != NONE);
-}
-
-typedef double DType;
-typedef std::vector<DType> Array;
+// frames per block of the thread pool.
+#define MEL_FRAMES_PER_BLOCK        256
 
 /***  Module Header  ******************************************************}}}*/
 /**
@@ -53,40 +28,6 @@ typedef std::vector<DType> Array;
 * @retval mel
 **/
 /**************************************************************************{{{*/
-std::function<DType(DType)> _fn_hz2mel(
-int mel_scale=HTK)
-{
-    switch (mel_scale) {
-    case HTK:
-        return [](DType x) { return 2595.0*log10(1.0 + x/700.0); };
-    case KALDI:
-        return [](DType x) { return 1127.0*log(1.0 + x/700.0); };
-    case SLANEY:
-        return [](DType x) { return (x >= 1000.0) ? (15.0 + log(x/1000.0)*(27.0/log(6.4)))
-                                                  : (3.0*x/200.0); };
-    }
-
-    // never come here.
-    return nullptr;
-}
-
-DType _hz2mel(
-DType freq,
-int mel_scale=HTK)
-{
-    return _fn_hz2mel(mel_scale)(freq);
-}
-
-Array _hz2mel(
-const Array& freq,
-int mel_scale=HTK)
-{
-    Array result;
-    std::transform(freq.begin(), freq.end(), std::back_inserter(result), _fn_hz2mel(mel_scale));
-
-    return result;
-}
-
 DECL_NIF(hz2mel) {
     Array freq_array;
     int mel_scale;
@@ -97,6 +38,8 @@ DECL_NIF(hz2mel) {
         return enif_make_badarg(env);
     }
 
+    YIELD_TO_DIRTY_CPU(hz2mel, freq_array.size());
+
     return enif_make_ok(env, enif_make_vector(env, _hz2mel(freq_array, mel_scale)));
 }
 
@@ -109,40 +52,6 @@ DECL_NIF(hz2mel) {
 * @retval frequency(hertz)
 **/
 /**************************************************************************{{{*/
-std::function<DType(DType)> _fn_mel2hz(
-int mel_scale=HTK)
-{
-    switch (mel_scale) {
-    case HTK:
-        return [](DType x) { return 700.0*(pow(10.0, x/2595.0) - 1.0); };
-    case KALDI:
-        return [](DType x) { return 700.0*(exp(x/1127.0) - 1.0); };
-    case SLANEY:
-        return [](DType x) { return (x >= 15.0) ? (1000.0*exp((log(6.4)/27.0)*(x - 15.0)))
-                                                : (200.0*x/3.0); };
-    }
-
-    // never come here.
-    return nullptr;
-}
-
-DType _mel2hz(
-DType mel,
-int mel_scale=HTK)
-{
-    return _fn_mel2hz(mel_scale)(mel);
-}
-
-Array _mel2hz(
-const Array& mel,
-int mel_scale=HTK)
-{
-    Array result;
-    std::transform(mel.begin(), mel.end(), std::back_inserter(result), _fn_mel2hz(mel_scale));
-
-    return result;
-}
-
 DECL_NIF(mel2hz) {
     Array mel_array;
     int mel_scale;
@@ -153,6 +62,8 @@ DECL_NIF(mel2hz) {
         return enif_make_badarg(env);
     }
 
+    YIELD_TO_DIRTY_CPU(mel2hz, mel_array.size());
+
     return enif_make_ok(env, enif_make_vector(env, _mel2hz(mel_array, mel_scale)));
 }
 
@@ -183,55 +94,53 @@ DECL_NIF(linspace) {
 
 /***  Module Header  ******************************************************}}}*/
 /**
-* create triangle filter bank
+* create mel filter bank
 * @par DESCRIPTION
-*   Create triangular filter bank from two vectors.
+*   Create mel filter bank with specified parameters.
 *
-* @retval filter bank.
+* @retval 
 **/
 /**************************************************************************{{{*/
-Array _create_triangular_filter_bank(
-const Array& fft_freqs,
-const Array& filter_freqs)
-{
-    const int max_row = fft_freqs.size();
-    const int max_col = filter_freqs.size();
+DECL_NIF(mel_filter_bank) {
+    int num_frequency_bins;
+    int num_mel_filters;
+    double min_frequency;
+    double max_frequency;
+    int sampling_rate;
+    bool norm;
+    int mel_scale;
+    bool triangularize_in_mel_space;
 
-    Array diff;    // vector[max_col - 1]
-    for (int i = 0; i < (max_col - 1); i++) {
-        diff.push_back(filter_freqs[i+1] - filter_freqs[i]); 
+    if (ality != 8
+    || !enif_get_int(env, term[0], &num_frequency_bins)
+    || !enif_get_int(env, term[1], &num_mel_filters)
+    || !enif_get_number(env, term[2], &min_frequency)
+    || !enif_get_number(env, term[3], &max_frequency)
+    || !enif_get_int(env, term[4], &sampling_rate)
+    || !enif_get_mel_scale(env, term[5], &mel_scale)
+    || !enif_get_bool(env, term[6], &norm)
+    || !enif_get_bool(env, term[7], &triangularize_in_mel_space)) {
+        return enif_make_badarg(env);
     }
 
-    Array slopes;  // matrix[max_row, max_col]
-    for (int i = 0; i < max_row; i++) {
-    for (int j = 0; j < max_col; j++) {
-        slopes.push_back(filter_freqs[j] - fft_freqs[i]);
-    }}
-
-    Array result;  // matrix[max_row, max_col - 2]
-    auto slopes_row = slopes.begin();
-    for (int i = 0; i < max_row; i++) {
-        for (int j = 0; j < (max_col - 2); j++) {
-            DType down_slope = - slopes_row[j] / diff[j];
-            DType up_slope   =   slopes_row[j+2] / diff[j+1];
-            result.push_back(std::max(std::min(down_slope, up_slope), (DType)0.0));
-        }
-        slopes_row += max_col;
-    }
+    YIELD_TO_DIRTY_CPU(mel_filter_bank, 4*num_frequency_bins*(num_mel_filters + 2));
 
-    return result;
+    Array mel_filters = _mel_filter_bank(num_frequency_bins, num_mel_filters, min_frequency, max_frequency, sampling_rate,
+                                         mel_scale, norm, triangularize_in_mel_space);
+
+    return enif_make_ok(env, enif_make_vector(env, std::move(mel_filters)));
 }
 
 /***  Module Header  ******************************************************}}}*/
 /**
-* create mel filter bank
+* create banded mel filter bank
 * @par DESCRIPTION
-*   Create mel filter bank with specified parameters.
+*   Create mel filter bank in banded form and keep it in the resource.
 *
-* @retval 
+* @retval {:ok, mel_bank}
 **/
 /**************************************************************************{{{*/
-DECL_NIF(mel_filter_bank) {
+DECL_NIF(mel_bank_create) {
     int num_frequency_bins;
     int num_mel_filters;
     double min_frequency;
@@ -249,38 +158,112 @@ DECL_NIF(mel_filter_bank) {
     || !enif_get_int(env, term[4], &sampling_rate)
     || !enif_get_mel_scale(env, term[5], &mel_scale)
     || !enif_get_bool(env, term[6], &norm)
-    || !enif_get_bool(env, term[7], &triangularize_in_mel_space)) {
+    || !enif_get_bool(env, term[7], &triangularize_in_mel_space)
+    || num_frequency_bins < 1 || num_mel_filters < 1) {
         return enif_make_badarg(env);
     }
 
-    Array filter_freqs = _linspace(_hz2mel(min_frequency, mel_scale), _hz2mel(max_frequency, mel_scale), num_mel_filters+2);
-    Array fft_freqs    = _linspace(0, int(sampling_rate / 2), num_frequency_bins);
-    if (triangularize_in_mel_space) {
-        fft_freqs = _hz2mel(fft_freqs, mel_scale);
-    }
-    else {
-        filter_freqs = _mel2hz(filter_freqs, mel_scale);
+    MelBank* mel_bank = new MelBank(_mel_bank(num_frequency_bins, num_mel_filters, min_frequency, max_frequency, sampling_rate,
+                                              mel_scale, norm, triangularize_in_mel_space));
+
+    return Resource<MelBank>::make_resource(env, mel_bank);
+}
+
+/***  Module Header  ******************************************************}}}*/
+/**
+* export dense mel filter bank
+* @par DESCRIPTION
+*   Expand banded mel filter bank to dense matrix.
+*
+* @retval matrix[n_freq, n_mels]
+**/
+/**************************************************************************{{{*/
+DECL_NIF(mel_bank_to_dense) {
+    MelBank* mel_bank;
+
+    if (ality != 1
+    || !Resource<MelBank>::get_item(env, term[0], &mel_bank)) {
+        return enif_make_badarg(env);
     }
 
-    Array mel_filters = _create_triangular_filter_bank(fft_freqs, filter_freqs);
+    return enif_make_ok(env, enif_make_vector(env, mel_bank->to_dense()));
+}
 
-    if (norm && mel_scale == SLANEY) {
-        Array enorm;
-        for (int j = 0; j < num_mel_filters; j++) {
-            enorm.push_back(2.0/(filter_freqs[j+2] - filter_freqs[j]));
-        }
+/***  Module Header  ******************************************************}}}*/
+/**
+* apply mel filter bank
+* @par DESCRIPTION
+*   Project power spectrogram[n_frames, n_freq] onto mel filter bank.
+*
+* @retval matrix[n_mels, n_frames]
+**/
+/**************************************************************************{{{*/
+template <typename T>
+ERL_NIF_TERM _mel_apply_nif(ErlNifEnv* env, const MelBank& mel_bank, const ErlNifBinary& bin)
+{
+    const size_t n_freq = mel_bank.n_freq();
+    const size_t n_mels = mel_bank.n_mels();
+
+    const size_t n_frames = bin.size / (n_freq*sizeof(T));
 
-        auto mel_filters_row = mel_filters.begin();
-        for (int i = 0; i < num_frequency_bins; i++) {
-            for (int j = 0; j < num_mel_filters; j++) {
-                mel_filters_row[j] *= enorm[j];
-            }
+    BinaryArray<T> mel;
+    if (!mel.alloc(n_mels*n_frames)) {
+        return enif_make_error(env);
+    }
 
-            mel_filters_row += num_mel_filters;
+    // frame blocks on the thread pool.
+    const T* power = reinterpret_cast<const T*>(bin.data);
+    parallel_for(n_frames, MEL_FRAMES_PER_BLOCK, [&](size_t begin, size_t end) {
+        for (size_t t = begin; t < end; t++) {
+            mel_bank.apply(&power[t*n_freq], &mel[t], n_frames);
         }
+    });
+
+    return enif_make_ok(env, enif_make_array(env, mel));
+}
+
+DECL_VALIDATE(mel_apply) {
+    MelBank* mel_bank;
+    ErlNifBinary power;
+    std::string dtype;
+
+    if (ality != 3
+    || !Resource<MelBank>::get_item(env, term[0], &mel_bank)
+    || !enif_inspect_binary(env, term[1], &power)
+    || !enif_align_binary(env, power, alignof(double))
+    || !enif_get_str(env, term[2], dtype)) {
+        return false;
     }
 
-    return enif_make_ok(env, enif_make_vector(env, std::move(mel_filters)));
+    // the power spectrogram has whole rows of n_freq.
+    const size_t unit = (dtype == "<f4") ? sizeof(float) : (dtype == "<f8") ? sizeof(double) : 0;
+    if (unit == 0 || power.size % (mel_bank->n_freq()*unit) != 0) {
+        return false;
+    }
+
+    *work = power.size/sizeof(float)*mel_bank->nnz()/mel_bank->n_freq();
+
+    if (dtype == "<f4") {
+        compute = [=](ErlNifEnv* env) { return _mel_apply_nif<float>(env, *mel_bank, power); };
+    }
+    else {
+        compute = [=](ErlNifEnv* env) { return _mel_apply_nif<double>(env, *mel_bank, power); };
+    }
+
+    return true;
+}
+
+DECL_NIF(mel_apply) {
+    AsyncCompute compute;
+    double work;
+
+    if (!mel_apply_validate(env, ality, term, compute, &work)) {
+        return enif_make_badarg(env);
+    }
+
+    YIELD_TO_DIRTY_CPU(mel_apply, work);
+
+    return compute(env);
 }
 
 /*** filter_bank.cc ******************************************************}}}*/
@@ -0,0 +1,278 @@
+/***  File Header  ************************************************************/
+/**
+* filter_bank.h
+*
+* Elixir/Erlang Port ext. of Post-processing for DNN.
+* @author   Shozo Fukuda
+* @date     create 2024-04-07 22:52:35
+* System    Windows10, WSL2/Ubuntu 20.04.2<br>
+*
+**/
+/**************************************************************************{{{*/
+#ifndef _FILTER_BANK_H
+#define _FILTER_BANK_H
+
+#include "my_erl_nif.h"
+#include "npy_utils.h"
+#include <cmath>
+#include <functional>
+#include <vector>
+#include <algorithm>
+
+enum MelScale {
+    NONE = 0,
+    HTK,
+    KALDI,
+    SLANEY
+};
+
+inline bool enif_get_mel_scale(ErlNifEnv* env, ERL_NIF_TERM term, int* mel_scale)
+{
+    char mel_scale_name[16];
+    int len;
+
+    if ((len = enif_get_atom(env, term, mel_scale_name, sizeof(mel_scale_name), ERL_NIF_LATIN1)) == 0) {
+        return false;
+    }
+
+    *mel_scale = (std::strcmp(mel_scale_name, "htk"   ) == 0) ? HTK
+               : (std::strcmp(mel_scale_name, "kaldi" ) == 0) ? KALDI
+               : (std::strcmp(mel_scale_name, "slaney") == 0) ? SLANEY
+               : NONE;
+
+    return (*mel_scale != NONE);
+}
+
+typedef double DType;
+typedef std::vector<DType> Array;
+
+/***  Module Header  ******************************************************}}}*/
+/**
+* Convert frequency(hertz) to mel
+* @par DESCRIPTION
+*   Convert frequency to mel in each method.
+*
+* @retval mel
+**/
+/**************************************************************************{{{*/
+inline std::function<DType(DType)> _fn_hz2mel(
+int mel_scale=HTK)
+{
+    switch (mel_scale) {
+    case HTK:
+        return [](DType x) { return 2595.0*log10(1.0 + x/700.0); };
+    case KALDI:
+        return [](DType x) { return 1127.0*log(1.0 + x/700.0); };
+    case SLANEY:
+        return [](DType x) { return (x >= 1000.0) ? (15.0 + log(x/1000.0)*(27.0/log(6.4)))
+                                                  : (3.0*x/200.0); };
+    }
+
+    // never come here.
+    return nullptr;
+}
+
+inline DType _hz2mel(
+DType freq,
+int mel_scale=HTK)
+{
+    return _fn_hz2mel(mel_scale)(freq);
+}
+
+inline Array _hz2mel(
+const Array& freq,
+int mel_scale=HTK)
+{
+    Array result;
+    std::transform(freq.begin(), freq.end(), std::back_inserter(result), _fn_hz2mel(mel_scale));
+
+    return result;
+}
+
+/***  Module Header  ******************************************************}}}*/
+/**
+* Reverse mel to frequency(hertz)
+* @par DESCRIPTION
+*   Reverse mel to frequency in each method.
+*
+* @retval frequency(hertz)
+**/
+/**************************************************************************{{{*/
+inline std::function<DType(DType)> _fn_mel2hz(
+int mel_scale=HTK)
+{
+    switch (mel_scale) {
+    case HTK:
+        return [](DType x) { return 700.0*(pow(10.0, x/2595.0) - 1.0); };
+    case KALDI:
+        return [](DType x) { return 700.0*(exp(x/1127.0) - 1.0); };
+    case SLANEY:
+        return [](DType x) { return (x >= 15.0) ? (1000.0*exp((log(6.4)/27.0)*(x - 15.0)))
+                                                : (200.0*x/3.0); };
+    }
+
+    // never come here.
+    return nullptr;
+}
+
+inline DType _mel2hz(
+DType mel,
+int mel_scale=HTK)
+{
+    return _fn_mel2hz(mel_scale)(mel);
+}
+
+inline Array _mel2hz(
+const Array& mel,
+int mel_scale=HTK)
+{
+    Array result;
+    std::transform(mel.begin(), mel.end(), std::back_inserter(result), _fn_mel2hz(mel_scale));
+
+    return result;
+}
+
+/***  Class Header  *******************************************************}}}*/
+/**
+* mel filter bank in banded form
+* @par description
+*   each triangular filter is non-zero over only a few frequency bins, so
+*   the filter bank keeps the band [start, end) and its weights per filter.
+*   applying it to the power spectrum costs O(nnz) instead of O(n_freq*n_mels).
+**/
+/**************************************************************************{{{*/
+class MelBank {
+public:
+    MelBank(const Array& fft_freqs, const Array& filter_freqs, bool norm=false)
+    {
+        m_n_freq = fft_freqs.size();
+        m_n_mels = filter_freqs.size() - 2;
+
+        m_start.reserve(m_n_mels);
+        m_end.reserve(m_n_mels);
+        m_offset.reserve(m_n_mels);
+        for (int j = 0; j < m_n_mels; j++) {
+            const DType lower  = filter_freqs[j];
+            const DType center = filter_freqs[j+1];
+            const DType upper  = filter_freqs[j+2];
+            const DType enorm  = norm ? 2.0/(upper - lower) : 1.0;
+
+            // fft_freqs is ascending: the band is the open interval (lower, upper).
+            int start = std::upper_bound(fft_freqs.begin(), fft_freqs.end(), lower) - fft_freqs.begin();
+            int end   = std::lower_bound(fft_freqs.begin(), fft_freqs.end(), upper) - fft_freqs.begin();
+
+            m_start.push_back(start);
+            m_end.push_back(std::max(start, end));
+            m_offset.push_back(m_weights.size());
+            for (int i = start; i < end; i++) {
+                DType down_slope = (fft_freqs[i] - lower) / (center - lower);
+                DType up_slope   = (upper - fft_freqs[i]) / (upper - center);
+                m_weights.push_back(enorm*std::max(std::min(down_slope, up_slope), (DType)0.0));
+            }
+        }
+    }
+
+    int    n_freq() const { return m_n_freq; }
+    int    n_mels() const { return m_n_mels; }
+    size_t nnz()    const { return m_weights.size(); }
+
+    // mel[j*stride] = sum of weights x power over the band of filter j.
+    template <typename T>
+    void apply(const T* power, T* mel, size_t stride=1) const
+    {
+        for (int j = 0; j < m_n_mels; j++) {
+            const DType* w = &m_weights[m_offset[j]];
+            DType sum = 0.0;
+            for (int i = m_start[j]; i < m_end[j]; i++) {
+                sum += (*w++)*power[i];
+            }
+            mel[j*stride] = T(sum);
+        }
+    }
+
+    // dense matrix[n_freq, n_mels]
+    Array to_dense() const
+    {
+        Array dense(size_t(m_n_freq)*m_n_mels, 0.0);
+        for (int j = 0; j < m_n_mels; j++) {
+            const DType* w = &m_weights[m_offset[j]];
+            for (int i = m_start[j]; i < m_end[j]; i++) {
+                dense[size_t(i)*m_n_mels + j] = *w++;
+            }
+        }
+        return dense;
+    }
+
+protected:
+    int m_n_freq;
+    int m_n_mels;
+    std::vector<int>    m_start;
+    std::vector<int>    m_end;
+    std::vector<size_t> m_offset;
+    Array               m_weights;
+};
+
+/***  Module Header  ******************************************************}}}*/
+/**
+* create triangle filter bank
+* @par DESCRIPTION
+*   Create triangular filter bank from two vectors.
+*
+* @retval filter bank.
+**/
+/**************************************************************************{{{*/
+inline Array _create_triangular_filter_bank(
+const Array& fft_freqs,
+const Array& filter_freqs)
+{
+    return MelBank(fft_freqs, filter_freqs).to_dense();
+}
+
+/***  Module Header  ******************************************************}}}*/
+/**
+* create mel filter bank
+* @par DESCRIPTION
+*   Create mel filter bank with specified parameters.
+*
+* @retval banded filter bank
+**/
+/**************************************************************************{{{*/
+inline MelBank _mel_bank(
+int    num_frequency_bins,
+int    num_mel_filters,
+double min_frequency,
+double max_frequency,
+int    sampling_rate,
+int    mel_scale=HTK,
+bool   norm=false,
+bool   triangularize_in_mel_space=false)
+{
+    Array filter_freqs = _linspace(_hz2mel(min_frequency, mel_scale), _hz2mel(max_frequency, mel_scale), num_mel_filters+2);
+    Array fft_freqs    = _linspace(0, int(sampling_rate / 2), num_frequency_bins);
+    if (triangularize_in_mel_space) {
+        fft_freqs = _hz2mel(fft_freqs, mel_scale);
+    }
+    else {
+        filter_freqs = _mel2hz(filter_freqs, mel_scale);
+    }
+
+    return MelBank(fft_freqs, filter_freqs, norm && mel_scale == SLANEY);
+}
+
+// dense matrix[num_frequency_bins, num_mel_filters]
+inline Array _mel_filter_bank(
+int    num_frequency_bins,
+int    num_mel_filters,
+double min_frequency,
+double max_frequency,
+int    sampling_rate,
+int    mel_scale=HTK,
+bool   norm=false,
+bool   triangularize_in_mel_space=false)
+{
+    return _mel_bank(num_frequency_bins, num_mel_filters, min_frequency, max_frequency, sampling_rate,
+                     mel_scale, norm, triangularize_in_mel_space).to_dense();
+}
+
+#endif
+/*** filter_bank.h *******************************************************}}}*/
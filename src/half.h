@@ -0,0 +1,125 @@
+/***  File Header  ************************************************************/
+/**
+* half.h
+*
+* Elixir/Erlang Port ext. of Post-processing for DNN.
+* @author   Shozo Fukuda
+* @date     create 2026-10-17 21:14:02
+* System    Windows10, WSL2/Ubuntu 20.04.2<br>
+*
+**/
+/**************************************************************************{{{*/
+#ifndef _HALF_H
+#define _HALF_H
+
+#include <cstdint>
+#include <cstring>
+
+/***  Class Header  *******************************************************}}}*/
+/**
+* IEEE 754 half precision (<f2)
+* @par description
+*   storage type of 16 bits. the conversion from float rounds to nearest
+*   even, overflows to inf and keeps subnormals, nan and the sign.
+**/
+/**************************************************************************{{{*/
+struct float16 {
+    uint16_t bits;
+
+    float16() : bits(0) {}
+    float16(float f) : bits(from_float(f)) {}
+
+    operator float() const { return to_float(bits); }
+
+    static uint16_t from_float(float f)
+    {
+        uint32_t x;
+        std::memcpy(&x, &f, sizeof(x));
+
+        const uint32_t sign = (x >> 16) & 0x8000;
+        uint32_t       absx = x & 0x7FFFFFFF;
+
+        if (absx >= 0x47800000) {
+            // inf/nan, or too large for half: 65520 and beyond round to inf.
+            return sign | ((absx > 0x7F800000) ? 0x7E00 : 0x7C00);
+        }
+        if (absx < 0x38800000) {
+            // subnormal half: let the float adder round at 2^-24.
+            float a;
+            std::memcpy(&a, &absx, sizeof(a));
+            a += 0.5f;
+            std::memcpy(&absx, &a, sizeof(absx));
+            return sign | uint16_t(absx - 0x3F000000);
+        }
+
+        // rebias the exponent and round the 13 dropped bits to nearest even.
+        absx += 0xC8000FFF + ((absx >> 13) & 1);
+        return sign | uint16_t(absx >> 13);
+    }
+
+    static float to_float(uint16_t h)
+    {
+        const uint32_t sign = uint32_t(h & 0x8000) << 16;
+        uint32_t       x    = uint32_t(h & 0x7FFF) << 13;
+        const uint32_t exp  = x & 0x0F800000;
+
+        x += (127 - 15) << 23;
+        if (exp == 0x0F800000) {
+            // inf/nan
+            x += (128 - 16) << 23;
+        }
+        else if (exp == 0) {
+            // subnormal: normalize by the float subtraction.
+            x += 1 << 23;
+            float f;
+            std::memcpy(&f, &x, sizeof(f));
+            f -= 6.103515625e-05f;      // 2^-14
+            std::memcpy(&x, &f, sizeof(x));
+        }
+        x |= sign;
+
+        float f;
+        std::memcpy(&f, &x, sizeof(f));
+        return f;
+    }
+};
+
+/***  Class Header  *******************************************************}}}*/
+/**
+* brain floating point (bf16)
+* @par description
+*   upper 16 bits of float. the conversion from float rounds to nearest
+*   even and keeps nan quiet.
+**/
+/**************************************************************************{{{*/
+struct bfloat16 {
+    uint16_t bits;
+
+    bfloat16() : bits(0) {}
+    bfloat16(float f) : bits(from_float(f)) {}
+
+    operator float() const { return to_float(bits); }
+
+    static uint16_t from_float(float f)
+    {
+        uint32_t x;
+        std::memcpy(&x, &f, sizeof(x));
+
+        if ((x & 0x7FFFFFFF) > 0x7F800000) {
+            return uint16_t((x >> 16) | 0x0040);
+        }
+        x += 0x7FFF + ((x >> 16) & 1);
+        return uint16_t(x >> 16);
+    }
+
+    static float to_float(uint16_t b)
+    {
+        uint32_t x = uint32_t(b) << 16;
+        float f;
+        std::memcpy(&f, &x, sizeof(f));
+        return f;
+    }
+};
+
+#endif
+/*** half.h **************************************************************}}}*/
@@ -11,20 +11,72 @@
 /**************************************************************************{{{*/
 
 #include "my_erl_nif.h"
+#include "audio.h"
+#include "filter_bank.h"
+#include "feature.h"
+#include "fft_plan.h"
+#include "resample.h"
+#include "simd.h"
+#include "thread_pool.h"
+#include "async_job.h"
 
 /**************************************************************************}}}*/
 /* enif resource setup                                                        */
 /**************************************************************************{{{*/
 int load(ErlNifEnv *env, void **priv_data, ERL_NIF_TERM load_info)
 {
+    Resource<WavReader>::init_resource_type(env, "WavReader");
+    Resource<WavWriter>::init_resource_type(env, "WavWriter");
+    Resource<MelBank>::init_resource_type(env, "MelBank");
+    Resource<FeatureHandle>::init_resource_type(env, "FeatureExtractor");
+    Resource<FftPlan<float>>::init_resource_type(env, "FftPlanF4");
+    Resource<FftPlan<double>>::init_resource_type(env, "FftPlan");
+    Resource<Resampler>::init_resource_type(env, "Resampler");
+    Resource<LogMelStream>::init_resource_type(env, "LogMelStream");
+
+    if (Resource<WavReader>::_ResType       == NULL
+    ||  Resource<WavWriter>::_ResType       == NULL
+    ||  Resource<MelBank>::_ResType         == NULL
+    ||  Resource<FeatureHandle>::_ResType   == NULL
+    ||  Resource<FftPlan<float>>::_ResType  == NULL
+    ||  Resource<FftPlan<double>>::_ResType == NULL
+    ||  Resource<Resampler>::_ResType       == NULL
+    ||  Resource<LogMelStream>::_ResType    == NULL) {
+        return -1;
+    }
+
+    // elementwise kernels after the CPU features.
+    simd_init();
+
+    // worker threads: load_info is {pool size, dirty CPU schedulers}, and
+    // the pool size 0 takes the number of dirty CPU schedulers.
+    int arity;
+    const ERL_NIF_TERM* info;
+    unsigned pool_size = 0, dirty_cpu = 0;
+    if (enif_get_tuple(env, load_info, &arity, &info) && arity == 2) {
+        enif_get_uint(env, info[0], &pool_size);
+        enif_get_uint(env, info[1], &dirty_cpu);
+    }
+    ThreadPool::set_default(dirty_cpu);
+    ThreadPool::start(pool_size);
+
+    // runners of the asynchronous jobs.
+    JobQueue::start();
+
     return 0;
 }
 
+void unload(ErlNifEnv *env, void *priv_data)
+{
+    JobQueue::stop();
+    ThreadPool::stop();
+}
+
 /**************************************************************************}}}*/
 /* enif function dispach table                                                */
 /**************************************************************************{{{*/
 #include "mozu_nif.inc"
 
-ERL_NIF_INIT(Elixir.Mozu.NIF, nif_funcs, load, NULL, NULL, NULL)
+ERL_NIF_INIT(Elixir.Mozu.NIF, nif_funcs, load, NULL, NULL, unload)
 
 /*** mozu_nif.cpp *****************************************************}}}*/
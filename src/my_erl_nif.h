@@ -3,12 +3,52 @@
 
 #include <erl_nif.h>
 #include <cstring>
+#include <cstdint>
 
 /***** NIFs HELPER *****/
 #define MUT
 #define  DECL_NIF(name)  ERL_NIF_TERM name(ErlNifEnv* env, int ality, const ERL_NIF_TERM term[])
 #define _DECL_NIF(name)  ERL_NIF_TERM name(ErlNifEnv* env, int ality, const ERL_NIF_TERM term[])
 
+// nif_tbl.py registers DECL_NIF_DIRTY_CPU/IO NIFs with the dirty CPU/IO flag;
+// plain DECL_NIF ones start on a normal scheduler, and move to a dirty CPU
+// scheduler only for large work by YIELD_TO_DIRTY_CPU.
+#define  DECL_NIF_DIRTY_CPU(name)  DECL_NIF(name)
+#define  DECL_NIF_DIRTY_IO(name)   DECL_NIF(name)
+
+/***  Module Header  ******************************************************}}}*/
+/**
+* size-based dirty scheduling
+* @par description
+*   a NIF running on a normal scheduler should return within 1ms. the work
+*   of the call is estimated in elementary operations; small work is done
+*   in place and reported with enif_consume_timeslice, large work is moved
+*   to a dirty CPU scheduler by re-scheduling the NIF itself.
+*
+* @return true if the NIF should be re-scheduled
+**/
+/**************************************************************************{{{*/
+#define NIF_WORK_PER_TIMESLICE  (1 << 18)
+
+inline bool enif_yield_to_dirty(ErlNifEnv* env, size_t work)
+{
+    if (enif_thread_type() != ERL_NIF_THR_NORMAL_SCHEDULER) {
+        return false;
+    }
+
+    if (work > NIF_WORK_PER_TIMESLICE) {
+        return true;
+    }
+
+    enif_consume_timeslice(env, 1 + int(99*work/NIF_WORK_PER_TIMESLICE));
+    return false;
+}
+
+#define YIELD_TO_DIRTY_CPU(name, work) \
+    if (enif_yield_to_dirty(env, (work))) { \
+        return enif_schedule_nif(env, #name, ERL_NIF_DIRTY_JOB_CPU_BOUND, name, ality, term); \
+    }
+
 /***  Module Header  ******************************************************}}}*/
 /**
 * make atom term
@@ -174,6 +214,35 @@ inline int enif_get_str(ErlNifEnv* env, ERL_NIF_TERM term, std::string& str)
     return true;
 }
 
+/***  Module Header  ******************************************************}}}*/
+/**
+* aligned binary data
+* @par description
+*   a sub-binary (binary_part, the body of an npy image, ...) may start at
+*   any byte. when the data of the inspected binary is not aligned for the
+*   element type, it is replaced by a copy in a new binary of env, which
+*   lives as long as env.
+*
+* @return succeed or fail
+**/
+/**************************************************************************{{{*/
+inline bool enif_align_binary(ErlNifEnv* env, ErlNifBinary& bin, size_t align)
+{
+    if (reinterpret_cast<uintptr_t>(bin.data) % align == 0) {
+        return true;
+    }
+
+    ERL_NIF_TERM term;
+    unsigned char* copy = enif_make_new_binary(env, bin.size, &term);
+    if (copy == nullptr) {
+        return false;
+    }
+    std::memcpy(copy, bin.data, bin.size);
+    bin.data = copy;
+
+    return true;
+}
+
 /***  Module Header  ******************************************************}}}*/
 /**
 * convert binary term to vector
@@ -190,7 +259,7 @@ bool enif_get_vector(ErlNifEnv* env, ERL_NIF_TERM term, std::vector<T>& array)
 {
     ErlNifBinary bin;
 
-    if (enif_inspect_binary(env, term, &bin)) {
+    if (enif_inspect_binary(env, term, &bin) && enif_align_binary(env, bin, alignof(T))) {
         T*  input = reinterpret_cast<T*>(bin.data);
         int count = bin.size/sizeof(T);
         array.assign(input, input+count);
@@ -207,7 +276,7 @@ bool enif_get_vector_as(ErlNifEnv* env, ERL_NIF_TERM term, std::vector<U>& array
 {
     ErlNifBinary bin;
 
-    if (enif_inspect_binary(env, term, &bin)) {
+    if (enif_inspect_binary(env, term, &bin) && enif_align_binary(env, bin, alignof(T))) {
         T*  input = reinterpret_cast<T*>(bin.data);
         int count = bin.size/sizeof(T);
         array.assign(input, input+count);
@@ -230,6 +299,113 @@ ERL_NIF_TERM enif_make_vector(ErlNifEnv* env, std::vector<T>&& array)
     return enif_make_tuple2(env, enif_make_uint(env, array.size()), term);
 }
 
+/***  Class Header  *******************************************************}}}*/
+/**
+* typed view of binary
+* @par description
+*   array view on the data of binary term (input) or allocated binary
+*   (output). kernels read and write it in place without std::vector copy;
+*   only a misaligned input is copied (see enif_align_binary).
+**/
+/**************************************************************************{{{*/
+template <typename T>
+class ArrayView {
+public:
+    ArrayView() : m_data(nullptr), m_size(0) {}
+    ArrayView(T* data, size_t size) : m_data(data), m_size(size) {}
+
+    T*     data()  const { return m_data; }
+    size_t size()  const { return m_size; }
+    bool   empty() const { return m_size == 0; }
+    T*     begin() const { return m_data; }
+    T*     end()   const { return m_data + m_size; }
+    T& operator[](size_t i) const { return m_data[i]; }
+
+protected:
+    T*     m_data;
+    size_t m_size;
+};
+
+template <typename T>
+bool enif_get_view(ErlNifEnv* env, ERL_NIF_TERM term, ArrayView<const T>& view)
+{
+    ErlNifBinary bin;
+
+    if (enif_inspect_binary(env, term, &bin) && (bin.size % sizeof(T)) == 0
+    && enif_align_binary(env, bin, alignof(T))) {
+        view = ArrayView<const T>(reinterpret_cast<const T*>(bin.data), bin.size/sizeof(T));
+        return true;
+    }
+    else {
+        return false;
+    }
+}
+
+template <typename T>
+class BinaryArray : public ArrayView<T> {
+public:
+    BinaryArray() : m_owned(false) {}
+    ~BinaryArray() {
+        if (m_owned) {
+            enif_release_binary(&m_bin);
+        }
+    }
+
+    bool alloc(size_t count) {
+        if (m_owned || !enif_alloc_binary(count*sizeof(T), &m_bin)) {
+            return false;
+        }
+        m_owned = true;
+        this->m_data = reinterpret_cast<T*>(m_bin.data);
+        this->m_size = count;
+        return true;
+    }
+
+    // the array can only shrink, kernels may compact the result in place.
+    bool shrink(size_t count) {
+        if (!m_owned || count > this->m_size || !enif_realloc_binary(&m_bin, count*sizeof(T))) {
+            return false;
+        }
+        this->m_data = reinterpret_cast<T*>(m_bin.data);
+        this->m_size = count;
+        return true;
+    }
+
+    // reinterpret the binary as array of other element type.
+    template <typename U>
+    bool recast(BinaryArray<U>& other) {
+        if (!m_owned || other.m_owned) {
+            return false;
+        }
+        other.m_bin   = m_bin;
+        other.m_owned = true;
+        other.m_data  = reinterpret_cast<U*>(m_bin.data);
+        other.m_size  = m_bin.size/sizeof(U);
+        m_owned = false;
+        this->m_data = nullptr;
+        this->m_size = 0;
+        return true;
+    }
+
+    ERL_NIF_TERM release(ErlNifEnv* env) {
+        m_owned = false;
+        return enif_make_binary(env, &m_bin);
+    }
+
+private:
+    template <typename U> friend class BinaryArray;
+
+    ErlNifBinary m_bin;
+    bool         m_owned;
+};
+
+template <typename T>
+ERL_NIF_TERM enif_make_array(ErlNifEnv* env, BinaryArray<T>& array)
+{
+    size_t count = array.size();
+    return enif_make_tuple2(env, enif_make_uint(env, count), array.release(env));
+}
+
 /***  Class Header  *******************************************************}}}*/
 /**
 * Erl resouce handling
@@ -13,74 +13,115 @@
 #include "my_erl_nif.h"
 #include <complex>
 #include "npy_utils.h"
+#include "thread_pool.h"
+#include "async_job.h"
+
+// elements per block of the thread pool.
+#define ASTYPE_ELEMENTS_PER_BLOCK   (1 << 16)
 
 /***  Module Header  ******************************************************}}}*/
 /**
 * dtype conversion
 * @par DESCRIPTION
-*   
+*   Convert the array binary from dtype to dtype in one pass, from the
+*   input binary straight into the output binary.
+*   real: <f4, <f8, <f2, bf16, <i4, <u4, <i2, <u1 (any to any)
+*   complex: <c8 <-> <c16
 *
-* @retval 
+* @retval {:ok, {count, binary}}
 **/
 /**************************************************************************{{{*/
-DECL_NIF(f4_astype) {
-    std::vector<float> input;
-    std::string type;
-
-    if (ality != 2
-    || !enif_get_vector(env, term[0], input)
-    || !enif_get_str(env, term[1], type)) {
-        return enif_make_badarg(env);
+template <typename T, typename U>
+ERL_NIF_TERM _astype_nif(ErlNifEnv* env, const ArrayView<const T>& input)
+{
+    BinaryArray<U> output;
+    if (!output.alloc(input.size())) {
+        return enif_make_error(env);
     }
 
-    return (type == "<f8") ? enif_make_ok(env, enif_make_vector(env, _astype<float,double>(input)))
-         : (type == "<i4") ? enif_make_ok(env, enif_make_vector(env, _astype<float,int>(input)))
-         : (type == "<u4") ? enif_make_ok(env, enif_make_vector(env, _astype<float,unsigned int>(input)))
-         : enif_make_badarg(env);
+    // element blocks on the thread pool.
+    parallel_for(input.size(), ASTYPE_ELEMENTS_PER_BLOCK, [&](size_t begin, size_t end) {
+        _astype(input.data() + begin, end - begin, output.data() + begin);
+    });
+
+    return enif_make_ok(env, enif_make_array(env, output));
 }
 
-DECL_NIF(f8_astype) {
-    std::vector<double> input;
-    std::string type;
+// the compute step of the conversion from T to U.
+template <typename T, typename U>
+AsyncCompute _astype_job(const ArrayView<const T>& input)
+{
+    return [=](ErlNifEnv* env) { return _astype_nif<T,U>(env, input); };
+}
 
-    if (ality != 2
-    || !enif_get_vector(env, term[0], input)
-    || !enif_get_str(env, term[1], type)) {
-        return enif_make_badarg(env);
+template <typename T>
+AsyncCompute _astype_to(ErlNifEnv* env, ERL_NIF_TERM term, const std::string& to)
+{
+    ArrayView<const T> input;
+    if (!enif_get_view(env, term, input)) {
+        return AsyncCompute();
     }
 
-    return (type == "<f4") ? enif_make_ok(env, enif_make_vector(env, _astype<double,float>(input)))
-         : (type == "<i4") ? enif_make_ok(env, enif_make_vector(env, _astype<double,int>(input)))
-         : (type == "<u4") ? enif_make_ok(env, enif_make_vector(env, _astype<double,unsigned int>(input)))
-         : enif_make_badarg(env);
+    return (to == "<f4" ) ? _astype_job<T,float>(input)
+         : (to == "<f8" ) ? _astype_job<T,double>(input)
+         : (to == "<f2" ) ? _astype_job<T,float16>(input)
+         : (to == "bf16") ? _astype_job<T,bfloat16>(input)
+         : (to == "<i4" ) ? _astype_job<T,int32_t>(input)
+         : (to == "<u4" ) ? _astype_job<T,uint32_t>(input)
+         : (to == "<i2" ) ? _astype_job<T,int16_t>(input)
+         : (to == "<u1" ) ? _astype_job<T,uint8_t>(input)
+         : AsyncCompute();
 }
 
-DECL_NIF(c16_astype) {
-    std::vector<std::complex<double>> input;
-    std::string type;
+DECL_VALIDATE(astype) {
+    ErlNifBinary data;
+    std::string from;
+    std::string to;
 
-    if (ality != 2
-    || !enif_get_vector(env, term[0], input)
-    || !enif_get_str(env, term[1], type)) {
-        return enif_make_badarg(env);
+    if (ality != 3
+    || !enif_inspect_binary(env, term[0], &data)
+    || !enif_get_str(env, term[1], from)
+    || !enif_get_str(env, term[2], to)) {
+        return false;
+    }
+
+    *work = data.size;
+
+    if (from == "<c8" || from == "<c16") {
+        ArrayView<const std::complex<float>>  c8;
+        ArrayView<const std::complex<double>> c16;
+        compute = (from == "<c8"  && to == "<c16" && enif_get_view(env, term[0], c8))
+                    ? _astype_job<std::complex<float>,std::complex<double>>(c8)
+                : (from == "<c16" && to == "<c8"  && enif_get_view(env, term[0], c16))
+                    ? _astype_job<std::complex<double>,std::complex<float>>(c16)
+                : AsyncCompute();
+    }
+    else {
+        compute = (from == "<f4" ) ? _astype_to<float>(env, term[0], to)
+                : (from == "<f8" ) ? _astype_to<double>(env, term[0], to)
+                : (from == "<f2" ) ? _astype_to<float16>(env, term[0], to)
+                : (from == "bf16") ? _astype_to<bfloat16>(env, term[0], to)
+                : (from == "<i4" ) ? _astype_to<int32_t>(env, term[0], to)
+                : (from == "<u4" ) ? _astype_to<uint32_t>(env, term[0], to)
+                : (from == "<i2" ) ? _astype_to<int16_t>(env, term[0], to)
+                : (from == "<u1" ) ? _astype_to<uint8_t>(env, term[0], to)
+                : AsyncCompute();
     }
 
-    return (type == "<c8") ? enif_make_ok(env, enif_make_vector(env, _astype<std::complex<double>,std::complex<float>>(input)))
-         : enif_make_badarg(env);
+    return bool(compute);
 }
 
-DECL_NIF(c8_astype) {
-    std::vector<std::complex<float>> input;
-    std::string type;
+DECL_NIF(astype) {
+    AsyncCompute compute;
+    double work;
 
-    if (ality != 2
-    || !enif_get_vector(env, term[0], input)
-    || !enif_get_str(env, term[1], type)) {
+    if (!astype_validate(env, ality, term, compute, &work)) {
         return enif_make_badarg(env);
     }
 
-    return (type == "<c8") ? enif_make_ok(env, enif_make_vector(env, _astype<std::complex<float>,std::complex<double>>(input)))
-         : enif_make_badarg(env);
+    YIELD_TO_DIRTY_CPU(astype, work);
+
+    return compute(env);
 }
 
 /*** npy_util.cc*** *******************************************************}}}*/
@@ -15,7 +15,11 @@
 #include "my_erl_nif.h"
 #include <vector>
 #include <algorithm>
-#include <iostream>
+#include <cmath>
+#include <complex>
+#include <limits>
+#include "simd.h"
+#include "half.h"
 
 /***  Module Header  ******************************************************}}}*/
 /**
@@ -45,26 +49,123 @@ bool   endpoint=true)
 
 /***  Module Header  ******************************************************}}}*/
 /**
-* 
+* dtype conversion
 * @par DESCRIPTION
-*   
+*   Convert each element from T to U. Every integer target (<i4, <u4, <i2,
+*   <u1) takes the same rule: the value is rounded to nearest even and
+*   saturated to the range (nan becomes 0); the SIMD kernels of <i4 follow
+*   it as well. Float conversions follow C++ casts; <f2/bf16 go through
+*   float.
 *
-* @retval 
+* @retval converted array
 **/
 /**************************************************************************{{{*/
+template <typename U>
+struct Cast {
+    template <typename T>
+    static U from(T x) { return U(x); }
+};
+
+template <typename U>
+struct SaturateCast {
+    template <typename T>
+    static U from(T x)
+    {
+        double v = double(x);
+        if (std::isnan(v)) {
+            return U(0);
+        }
+        v = std::nearbyint(v);
+        return (v <= double(std::numeric_limits<U>::min())) ? std::numeric_limits<U>::min()
+             : (v >= double(std::numeric_limits<U>::max())) ? std::numeric_limits<U>::max()
+             : U(v);
+    }
+};
+
+template <> struct Cast<int32_t>  : SaturateCast<int32_t>  {};
+template <> struct Cast<uint32_t> : SaturateCast<uint32_t> {};
+template <> struct Cast<int16_t>  : SaturateCast<int16_t>  {};
+template <> struct Cast<uint8_t>  : SaturateCast<uint8_t>  {};
+
+template <typename T, typename U>
+void _astype(const T* input, size_t count, U* output)
+{
+    for (size_t i = 0; i < count; i++) {
+        output[i] = Cast<U>::from(input[i]);
+    }
+}
+
+// the common conversions run on the SIMD kernels selected at load.
+inline void _astype(const float* input, size_t count, double* output)
+{
+    simd().f4_to_f8(input, count, output);
+}
+
+inline void _astype(const double* input, size_t count, float* output)
+{
+    simd().f8_to_f4(input, count, output);
+}
+
+inline void _astype(const float* input, size_t count, int32_t* output)
+{
+    simd().f4_to_i4(input, count, output);
+}
+
+inline void _astype(const double* input, size_t count, int32_t* output)
+{
+    simd().f8_to_i4(input, count, output);
+}
+
+inline void _astype(const std::complex<float>* input, size_t count, std::complex<double>* output)
+{
+    simd().f4_to_f8(reinterpret_cast<const float*>(input), 2*count, reinterpret_cast<double*>(output));
+}
+
+inline void _astype(const std::complex<double>* input, size_t count, std::complex<float>* output)
+{
+    simd().f8_to_f4(reinterpret_cast<const double*>(input), 2*count, reinterpret_cast<float*>(output));
+}
+
 template <typename T, typename U>
 std::vector<U> _astype(const std::vector<T>& input)
 {
-    return std::vector<U>(input.begin(), input.end());
+    std::vector<U> output(input.size());
+    _astype(input.data(), input.size(), output.data());
+
+    return output;
+}
+
+/***  Module Header  ******************************************************}}}*/
+/**
+* floored log10
+* @par DESCRIPTION
+*   log10(max(x, floor)) of each element. It may be applied in place.
+*
+* @retval none
+**/
+/**************************************************************************{{{*/
+template <typename T>
+void _log10(const T* input, size_t count, T floor, T* output)
+{
+    for (size_t i = 0; i < count; i++) {
+        output[i] = std::log10(std::max(input[i], floor));
+    }
+}
+
+inline void _log10(const float* input, size_t count, float floor, float* output)
+{
+    simd().log10_f4(input, count, floor, output);
 }
 
 /***  Module Header  ******************************************************}}}*/
 /**
-* 
+* padding
 * @par DESCRIPTION
-*   
+*   Map the index of the padded signal onto the source samples.
+*   reflect folds the index back and forth over [0, size) like numpy.pad,
+*   so the pad may be longer than the signal itself.
 *
-* @retval 
+* @retval index of the source sample, or -1 for the zero padding
 **/
 /**************************************************************************{{{*/
 enum PAD_MODE {
@@ -73,54 +174,147 @@ enum PAD_MODE {
     PAD_REFLECT
 };
 
-template <typename T>
-void _pad(std::vector<T>& array, size_t front_size, size_t rear_size, int mode=PAD_ZERO)
+inline ptrdiff_t _pad_index(ptrdiff_t i, size_t size, int mode=PAD_ZERO)
 {
-    std::cout << "front:" << front_size << ", rear:" << rear_size << ", mode:" << mode << std::endl;
-
-    if (front_size > 0) {
-        // padding front
-        std::vector<T> front_pad(front_size);
-        switch (mode) {
-        case PAD_EDGE:
-            // edge
-            front_pad.assign(front_size, array.front());
-            break;
-        case PAD_REFLECT:
-            // refrect
-            std::reverse_copy(array.begin()+1, array.begin()+front_size+1, front_pad.begin());
-            break;
-        case PAD_ZERO:
-        default:
-            // zero fill
-            front_pad.assign(front_size, 0);
-            break;
+    const ptrdiff_t n = size;
+    if (0 <= i && i < n) {
+        return i;
+    }
+
+    switch (mode) {
+    case PAD_EDGE:
+        return (i < 0) ? 0 : n - 1;
+    case PAD_REFLECT:
+        if (n == 1) {
+            return 0;
         }
+        else {
+            const ptrdiff_t period = 2*(n - 1);
+            ptrdiff_t j = i % period;
+            if (j < 0) {
+                j += period;
+            }
+            return (j < n) ? j : period - j;
+        }
+    case PAD_ZERO:
+    default:
+        return -1;
+    }
+}
+
+/***  Class Header  *******************************************************}}}*/
+/**
+* virtually padded signal
+* @par description
+*   the source signal with front/rear padding that is never materialized.
+*   boundary samples are synthesized on demand, and a range inside the
+*   source is read straight from it.
+**/
+/**************************************************************************{{{*/
+template <typename T>
+class PaddedView {
+public:
+    PaddedView(const T* src, size_t size, size_t front=0, size_t rear=0, int mode=PAD_ZERO)
+    : m_src(src), m_size(size), m_front(front), m_rear(rear), m_mode(mode)
+    {}
+
+    size_t size() const { return m_front + m_size + m_rear; }
 
-        array.insert(array.begin(), front_pad.begin(), front_pad.end());
+    // range [pos, pos+count) of the padded signal lies inside the source.
+    bool inside(size_t pos, size_t count) const {
+        return pos >= m_front && pos + count <= m_front + m_size;
     }
 
-    if (rear_size > 0) {
-        // padding rear
-        std::vector<T> rear_pad(rear_size);
-        switch (mode) {
-        case PAD_EDGE:
-            // edge
-            rear_pad.assign(rear_size, array.back());
-            break;
-        case PAD_REFLECT:
-            // refrect
-            std::reverse_copy(array.end()-rear_size-1, array.end()-1, rear_pad.begin());
-            break;
-        case PAD_ZERO:
-        default:
-            // zero fill
-            rear_pad.assign(rear_size, 0);
-            break;
+    // pointer to the padded signal at pos; valid only if inside(pos, ...).
+    const T* at(size_t pos) const { return m_src + (pos - m_front); }
+
+    // copy the padded samples [pos, pos+count) into dst.
+    template <typename U>
+    void copy(size_t pos, size_t count, U* dst) const
+    {
+        ptrdiff_t i   = ptrdiff_t(pos) - ptrdiff_t(m_front);
+        U*        end = dst + count;
+
+        for (; dst < end && i < 0; i++) {
+            *dst++ = sample<U>(i);
+        }
+        if (dst < end && i < ptrdiff_t(m_size)) {
+            size_t n = std::min(size_t(end - dst), m_size - size_t(i));
+            dst = std::copy(m_src + i, m_src + i + n, dst);
+            i  += n;
         }
+        for (; dst < end; i++) {
+            *dst++ = sample<U>(i);
+        }
+    }
+
+protected:
+    template <typename U>
+    U sample(ptrdiff_t i) const {
+        ptrdiff_t j = _pad_index(i, m_size, m_mode);
+        return (j < 0) ? U(0) : U(m_src[j]);
+    }
+
+    const T* m_src;
+    size_t   m_size;
+    size_t   m_front;
+    size_t   m_rear;
+    int      m_mode;
+};
+
+/***  Module Header  ******************************************************}}}*/
+/**
+* pad array
+* @par DESCRIPTION
+*   Write the padded signal straight into the output of the final size.
+*
+* @retval none
+**/
+/**************************************************************************{{{*/
+template <typename T>
+void _pad(const T* src, size_t size, T* dst, size_t front_size, size_t rear_size, int mode=PAD_ZERO)
+{
+    PaddedView<T> view(src, size, front_size, rear_size, mode);
+    view.copy(0, view.size(), dst);
+}
+
+template <typename T>
+void _pad(std::vector<T>& array, size_t front_size, size_t rear_size, int mode=PAD_ZERO)
+{
+    std::vector<T> padded(front_size + array.size() + rear_size);
+    _pad(array.data(), array.size(), padded.data(), front_size, rear_size, mode);
+    array.swap(padded);
+}
+
+/***  Module Header  ******************************************************}}}*/
+/**
+* window functions
+* @par DESCRIPTION
+*   Generate hanning/hamming window of N points.
+*
+* @retval window
+**/
+/**************************************************************************{{{*/
+template <typename T>
+std::vector<T> _hanning(int N)
+{
+    std::vector<T> w(N);
+    for (int i = 0; i < N; i++) {
+        w[i] = 0.5*(1 - cos(2*M_PI*i/(N-1))); 
+    }
+
+    return w;
+}
 
-        array.insert(array.end(), rear_pad.begin(), rear_pad.end());
+template <typename T>
+std::vector<T> _hamming(int N)
+{
+    std::vector<T> w(N);
+    for (int i = 0; i < N; i++) {
+        w[i] = 0.54 - 0.46*cos(2*M_PI*i/(N-1)); 
     }
+
+    return w;
 }
 
 #endif
@@ -0,0 +1,195 @@
+/***  File Header  ************************************************************/
+/**
+* resample.cc
+*
+* Elixir/Erlang Port ext. of Post-processing for DNN.
+* @author   Shozo Fukuda
+* @date     create 2026-10-17 17:40:12
+* System    Windows10, WSL2/Ubuntu 20.04.2<br>
+*
+**/
+/**************************************************************************{{{*/
+
+#include "my_erl_nif.h"
+#include <map>
+#include <mutex>
+#include <numeric>
+
+#include "resample.h"
+#include "async_job.h"
+
+/***  Module Header  ******************************************************}}}*/
+/**
+* resampling filter cache
+* @par DESCRIPTION
+*   Return the shared filter of the rate ratio from:to reduced by the gcd,
+*   so 44100->16000 and 88200->32000 use the same table.
+*
+* @retval resampling filter
+**/
+/**************************************************************************{{{*/
+std::shared_ptr<const ResampleFilter> ResampleFilter::get(int from, int to)
+{
+    static std::mutex mutex;
+    static std::map<std::pair<int, int>, ResampleFilterHandle> cache;
+
+    const int g = std::gcd(from, to);
+    const std::pair<int, int> ratio(to/g, from/g);
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto found = cache.find(ratio);
+    if (found != cache.end()) {
+        return found->second;
+    }
+
+    ResampleFilterHandle filter = std::make_shared<const ResampleFilter>(ratio.first, ratio.second);
+    cache.emplace(ratio, filter);
+
+    return filter;
+}
+
+/***  Module Header  ******************************************************}}}*/
+/**
+* resample wave
+* @par DESCRIPTION
+*   Convert the sampling rate of interleaved PCM <f4 from `from` to `to`
+*   in one shot.
+*
+* @retval resampled wave
+**/
+/**************************************************************************{{{*/
+static ERL_NIF_TERM _resample_nif(ErlNifEnv* env, const ArrayView<const float>& wave, int channels, int from, int to)
+{
+    Resampler resampler(channels, ResampleFilter::get(from, to));
+
+    const size_t n_frames = wave.size() / channels;
+
+    BinaryArray<float> output;
+    if (!output.alloc(resampler.max_output(n_frames)*channels)) {
+        return enif_make_error(env);
+    }
+
+    size_t count = resampler.push(wave.data(), n_frames, output.data());
+    count += resampler.flush(&output[count*channels]);
+    output.shrink(count*channels);
+
+    return enif_make_ok(env, enif_make_array(env, output));
+}
+
+DECL_VALIDATE(resample) {
+    ArrayView<const float> wave;
+    int channels;
+    int from;
+    int to;
+
+    if (ality != 4
+    || !enif_get_view(env, term[0], wave)
+    || !enif_get_int(env, term[1], &channels)
+    || !enif_get_int(env, term[2], &from)
+    || !enif_get_int(env, term[3], &to)
+    || channels < 1 || from < 1 || to < 1
+    || wave.size() % channels != 0) {
+        return false;
+    }
+
+    *work = double(wave.size())*to/from;
+
+    compute = [=](ErlNifEnv* env) { return _resample_nif(env, wave, channels, from, to); };
+
+    return true;
+}
+
+DECL_NIF_DIRTY_CPU(resample) {
+    AsyncCompute compute;
+    double work;
+
+    if (!resample_validate(env, ality, term, compute, &work)) {
+        return enif_make_badarg(env);
+    }
+
+    return compute(env);
+}
+
+/***  Module Header  ******************************************************}}}*/
+/**
+* streaming resampler
+* @par DESCRIPTION
+*   Open the resampler resource, push chunks of interleaved PCM <f4 through
+*   it, and flush the tail at the end of the stream.
+*
+* @retval {:ok, resampler} / resampled chunk
+**/
+/**************************************************************************{{{*/
+DECL_NIF(resampler_open) {
+    int channels;
+    int from;
+    int to;
+
+    if (ality != 3
+    || !enif_get_int(env, term[0], &channels)
+    || !enif_get_int(env, term[1], &from)
+    || !enif_get_int(env, term[2], &to)
+    || channels < 1 || from < 1 || to < 1) {
+        return enif_make_badarg(env);
+    }
+
+    YIELD_TO_DIRTY_CPU(resampler_open, to/std::gcd(from, to)*ResampleFilter::ZERO_CROSSINGS*64);
+
+    return Resource<Resampler>::make_resource(env, new Resampler(channels, ResampleFilter::get(from, to)));
+}
+
+DECL_NIF_DIRTY_CPU(resampler_push) {
+    Resampler* resampler;
+    ArrayView<const float> wave;
+
+    if (ality != 2
+    || !Resource<Resampler>::get_item(env, term[0], &resampler)
+    || !enif_get_view(env, term[1], wave)
+    || wave.size() % resampler->channels() != 0) {
+        return enif_make_badarg(env);
+    }
+
+    const size_t n_frames = wave.size() / resampler->channels();
+
+    resampler->lock();
+
+    BinaryArray<float> output;
+    if (!output.alloc(resampler->max_output(n_frames)*resampler->channels())) {
+        resampler->unlock();
+        return enif_make_error(env);
+    }
+
+    size_t count = resampler->push(wave.data(), n_frames, output.data());
+    output.shrink(count*resampler->channels());
+
+    resampler->unlock();
+
+    return enif_make_ok(env, enif_make_array(env, output));
+}
+
+DECL_NIF(resampler_flush) {
+    Resampler* resampler;
+
+    if (ality != 1
+    || !Resource<Resampler>::get_item(env, term[0], &resampler)) {
+        return enif_make_badarg(env);
+    }
+
+    resampler->lock();
+
+    BinaryArray<float> output;
+    if (!output.alloc(resampler->max_output(0)*resampler->channels())) {
+        resampler->unlock();
+        return enif_make_error(env);
+    }
+
+    size_t count = resampler->flush(output.data());
+    output.shrink(count*resampler->channels());
+
+    resampler->unlock();
+
+    return enif_make_ok(env, enif_make_array(env, output));
+}
+
+/*** resample.cc *********************************************************}}}*/
@@ -0,0 +1,254 @@
+/***  File Header  ************************************************************/
+/**
+* resample.h
+*
+* Elixir/Erlang Port ext. of Post-processing for DNN.
+* @author   Shozo Fukuda
+* @date     create 2026-10-17 17:40:12
+* System    Windows10, WSL2/Ubuntu 20.04.2<br>
+*
+**/
+/**************************************************************************{{{*/
+#ifndef _RESAMPLE_H
+#define _RESAMPLE_H
+
+#include "my_erl_nif.h"
+#include <vector>
+#include <memory>
+#include <cstring>
+#include <cstdint>
+#include <cmath>
+
+/***  Module Header  ******************************************************}}}*/
+/**
+* inner product
+* @par DESCRIPTION
+*   Dot product of two float arrays of n (multiple of 8) elements.
+*   GCC/Clang vector extensions let the compiler emit SSE/AVX/NEON code
+*   for the target without intrinsics.
+*
+* @retval sum of a[i]*b[i]
+**/
+/**************************************************************************{{{*/
+inline float _dot8(const float* a, const float* b, size_t n)
+{
+#if defined(__GNUC__)
+    typedef float v8sf __attribute__((vector_size(32)));
+
+    v8sf acc = {0};
+    for (size_t i = 0; i < n; i += 8) {
+        v8sf x, y;
+        std::memcpy(&x, a + i, sizeof(x));
+        std::memcpy(&y, b + i, sizeof(y));
+        acc += x*y;
+    }
+    return (acc[0] + acc[4]) + (acc[1] + acc[5]) + (acc[2] + acc[6]) + (acc[3] + acc[7]);
+#else
+    float acc[8] = {0};
+    for (size_t i = 0; i < n; i += 8) {
+        for (int j = 0; j < 8; j++) {
+            acc[j] += a[i+j]*b[i+j];
+        }
+    }
+    return (acc[0] + acc[4]) + (acc[1] + acc[5]) + (acc[2] + acc[6]) + (acc[3] + acc[7]);
+#endif
+}
+
+/***  Class Header  *******************************************************}}}*/
+/**
+* polyphase resampling filter
+* @par description
+*   Kaiser windowed sinc low-pass for the rate ratio up/down, split into
+*   `up` phases of `taps` coefficients (padded to a multiple of 8).
+*   output sample at input position i + p/up is the inner product of phase p
+*   and the input x[i-half+1 .. i-half+taps].
+*   it is immutable, and shared through the cache per reduced ratio.
+**/
+/**************************************************************************{{{*/
+class ResampleFilter {
+public:
+    static const int ZERO_CROSSINGS = 16;
+
+    ResampleFilter(int up, int down) : m_up(up), m_down(down)
+    {
+        const double rolloff = 0.945;
+        const double beta    = 8.6;
+
+        // cutoff relative to the input Nyquist; the filter widens for downsampling.
+        const double cutoff = std::min(1.0, double(up)/down)*rolloff;
+        m_half = int(std::ceil(ZERO_CROSSINGS/cutoff));
+        m_taps = (2*m_half + 7) & ~7;
+
+        m_coef.resize(size_t(up)*m_taps);
+        for (int p = 0; p < up; p++) {
+            float* coef = &m_coef[size_t(p)*m_taps];
+            double sum  = 0.0;
+            for (int k = 0; k < m_taps; k++) {
+                // distance in input samples from the output position.
+                double t = double(p)/up + m_half - 1 - k;
+                double u = t/m_half;
+                double h = (std::fabs(u) < 1.0)
+                         ? cutoff*sinc(cutoff*t)*bessel_i0(beta*std::sqrt(1.0 - u*u))/bessel_i0(beta)
+                         : 0.0;
+                coef[k] = float(h);
+                sum    += h;
+            }
+            // unit DC gain on every phase.
+            for (int k = 0; k < m_taps; k++) {
+                coef[k] = float(coef[k]/sum);
+            }
+        }
+    }
+
+    static std::shared_ptr<const ResampleFilter> get(int from, int to);
+
+    int up()   const { return m_up;   }
+    int down() const { return m_down; }
+    int half() const { return m_half; }
+    int taps() const { return m_taps; }
+
+    const float* phase(int p) const { return &m_coef[size_t(p)*m_taps]; }
+
+protected:
+    static double sinc(double x) {
+        return (x == 0.0) ? 1.0 : std::sin(M_PI*x)/(M_PI*x);
+    }
+
+    static double bessel_i0(double x) {
+        double sum = 1.0, term = 1.0;
+        for (int k = 1; k < 50 && term > 1e-12*sum; k++) {
+            term *= (x/(2*k))*(x/(2*k));
+            sum  += term;
+        }
+        return sum;
+    }
+
+    int                m_up;
+    int                m_down;
+    int                m_half;
+    int                m_taps;
+    std::vector<float> m_coef;
+};
+
+typedef std::shared_ptr<const ResampleFilter> ResampleFilterHandle;
+
+/***  Class Header  *******************************************************}}}*/
+/**
+* streaming resampler
+* @par description
+*   keep the filter history of each channel and the phase of the next output
+*   between chunks, so that a stream resampled chunk by chunk is identical to
+*   the one-shot result. the history may be shared between processes, so
+*   every access is serialized by the mutex.
+**/
+/**************************************************************************{{{*/
+class Resampler {
+public:
+    Resampler(int channels, ResampleFilterHandle filter)
+    : m_channels(channels), m_filter(filter), m_history(channels), m_base(0), m_index(0), m_phase(0),
+      m_n_input(0), m_n_output(0)
+    {
+        // the first output looks back half-1 samples before the start: zeros.
+        for (auto& history : m_history) {
+            history.assign(m_filter->half() - 1, 0.0f);
+        }
+        m_base  = -(m_filter->half() - 1);
+        m_mutex = enif_mutex_create((char*)"mozu.resampler");
+    }
+
+    ~Resampler() {
+        enif_mutex_destroy(m_mutex);
+    }
+
+    int channels() const { return m_channels; }
+
+    // upper bound of the output frames for n more input frames (+ flush).
+    size_t max_output(size_t n) const {
+        return size_t((double(n) + m_filter->taps())*m_filter->up()/m_filter->down()) + 2;
+    }
+
+    // consume interleaved input[n*channels], write interleaved output; return output frames.
+    size_t push(const float* input, size_t n, float* output)
+    {
+        for (int c = 0; c < m_channels; c++) {
+            std::vector<float>& history = m_history[c];
+            size_t size = history.size();
+            history.resize(size + n);
+            for (size_t i = 0; i < n; i++) {
+                history[size + i] = input[i*m_channels + c];
+            }
+        }
+        m_n_input += n;
+
+        return produce(output, SIZE_MAX);
+    }
+
+    // drain the samples still in the filter; return output frames.
+    size_t flush(float* output)
+    {
+        const size_t total = (m_n_input*m_filter->up() + m_filter->down() - 1)/m_filter->down();
+
+        for (auto& history : m_history) {
+            history.resize(history.size() + m_filter->taps(), 0.0f);
+        }
+
+        return produce(output, (total > m_n_output) ? total - m_n_output : 0);
+    }
+
+    void lock()   { enif_mutex_lock(m_mutex);   }
+    void unlock() { enif_mutex_unlock(m_mutex); }
+
+protected:
+    size_t produce(float* output, size_t limit)
+    {
+        const int up   = m_filter->up();
+        const int down = m_filter->down();
+        const int taps = m_filter->taps();
+        const long long end = m_base + (long long)m_history[0].size();
+
+        size_t count = 0;
+        while (count < limit) {
+            // input window of the next output: x[index-half+1 .. index-half+taps]
+            long long start = m_index - m_filter->half() + 1;
+            if (start + taps > end) {
+                break;
+            }
+
+            const float* coef = m_filter->phase(m_phase);
+            for (int c = 0; c < m_channels; c++) {
+                output[count*m_channels + c] = _dot8(coef, &m_history[c][start - m_base], taps);
+            }
+            count++;
+
+            m_phase += down;
+            m_index += m_phase / up;
+            m_phase %= up;
+        }
+        m_n_output += count;
+
+        // drop the history no longer looked back by the next output.
+        long long keep = m_index - m_filter->half() + 1;
+        if (keep > m_base) {
+            size_t drop = std::min<long long>(keep - m_base, (long long)m_history[0].size());
+            for (auto& history : m_history) {
+                history.erase(history.begin(), history.begin() + drop);
+            }
+            m_base += drop;
+        }
+
+        return count;
+    }
+
+    int                             m_channels;
+    ResampleFilterHandle            m_filter;
+    std::vector<std::vector<float>> m_history;
+    long long                       m_base;     // input index of history[0]
+    long long                       m_index;    // input index of the next output
+    int                             m_phase;    // sub-sample phase of the next output
+    size_t                          m_n_input;
+    size_t                          m_n_output;
+    ErlNifMutex*                    m_mutex;
+};
+
+#endif
+/*** resample.h **********************************************************}}}*/
@@ -0,0 +1,772 @@
+/***  File Header  ************************************************************/
+/**
+* simd.cc
+*
+* Elixir/Erlang Port ext. of Post-processing for DNN.
+* @author   Shozo Fukuda
+* @date     create 2026-10-17 20:05:31
+* System    Windows10, WSL2/Ubuntu 20.04.2<br>
+*
+**/
+/**************************************************************************{{{*/
+
+#include "my_erl_nif.h"
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <limits>
+#include "simd.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define MOZU_SIMD_X86
+#include <immintrin.h>
+#endif
+
+#if defined(__aarch64__)
+#define MOZU_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+/***  Module Header  ******************************************************}}}*/
+/**
+* scalar kernels
+* @par DESCRIPTION
+*   Portable fallback, and the tail of the vector kernels.
+*
+* @retval none
+**/
+/**************************************************************************{{{*/
+const int32_t I4_MIN = std::numeric_limits<int32_t>::min();
+const int32_t I4_MAX = std::numeric_limits<int32_t>::max();
+
+template <typename T>
+static void _abs_scalar(const T* input, size_t count, T* output)
+{
+    for (size_t i = 0; i < count; i++) {
+        const T re = input[2*i], im = input[2*i+1];
+        output[i] = std::sqrt(re*re + im*im);
+    }
+}
+
+template <typename T>
+static void _norm_scalar(const T* input, size_t count, T* output)
+{
+    for (size_t i = 0; i < count; i++) {
+        const T re = input[2*i], im = input[2*i+1];
+        output[i] = re*re + im*im;
+    }
+}
+
+template <typename T, typename U>
+static void _convert_scalar(const T* input, size_t count, U* output)
+{
+    for (size_t i = 0; i < count; i++) {
+        output[i] = U(input[i]);
+    }
+}
+
+// round to nearest even and saturate; nan becomes 0 (same as SaturateCast).
+template <typename T>
+static void _to_i4_scalar(const T* input, size_t count, int32_t* output)
+{
+    for (size_t i = 0; i < count; i++) {
+        const double v = std::nearbyint(double(input[i]));
+        output[i] = std::isnan(v)           ? 0
+                  : (v <= double(I4_MIN)) ? I4_MIN
+                  : (v >= double(I4_MAX)) ? I4_MAX
+                  : int32_t(v);
+    }
+}
+
+static void _log10_scalar(const float* input, size_t count, float floor, float* output)
+{
+    for (size_t i = 0; i < count; i++) {
+        output[i] = std::log10(std::max(input[i], floor));
+    }
+}
+
+static const SimdKernels SCALAR = {
+    "scalar",
+    _abs_scalar<float>,
+    _abs_scalar<double>,
+    _norm_scalar<float>,
+    _norm_scalar<double>,
+    _convert_scalar<float,double>,
+    _convert_scalar<double,float>,
+    _to_i4_scalar<float>,
+    _to_i4_scalar<double>,
+    _log10_scalar
+};
+
+// natural log by the Cephes polynomial on the mantissa in [sqrt(0.5), sqrt(2)).
+namespace LogPoly {
+    const float SQRTHF = 0.707106781186547524f;
+    const float P0 =  7.0376836292e-2f;
+    const float P1 = -1.1514610310e-1f;
+    const float P2 =  1.1676998740e-1f;
+    const float P3 = -1.2420140846e-1f;
+    const float P4 =  1.4249322787e-1f;
+    const float P5 = -1.6668057665e-1f;
+    const float P6 =  2.0000714765e-1f;
+    const float P7 = -2.4999993993e-1f;
+    const float P8 =  3.3333331174e-1f;
+    const float Q1 = -2.12194440e-4f;
+    const float Q2 =  0.693359375f;
+    const float LOG10E = 0.434294481903251828f;
+
+    // the polynomial holds for the positive normal floats only.
+    const float NORM_MIN = std::numeric_limits<float>::min();
+    const float INF      = std::numeric_limits<float>::infinity();
+}
+
+#ifdef MOZU_SIMD_X86
+/***  Module Header  ******************************************************}}}*/
+/**
+* AVX2 kernels
+* @par DESCRIPTION
+*   8 floats / 4 doubles per step. compiled for AVX2+FMA by the target
+*   attribute, and called only if the CPU supports it.
+*
+* @retval none
+**/
+/**************************************************************************{{{*/
+#define AVX2 __attribute__((target("avx2,fma")))
+
+// |re, im| pairs of 8 complex -> re^2+im^2 in order
+AVX2 static inline __m256 _norm8_avx2(const float* p)
+{
+    __m256 a = _mm256_loadu_ps(p);
+    __m256 b = _mm256_loadu_ps(p + 8);
+    // hadd pairs within 128-bit lanes: n0 n1 n4 n5 | n2 n3 n6 n7
+    __m256 h = _mm256_hadd_ps(_mm256_mul_ps(a, a), _mm256_mul_ps(b, b));
+    return _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(h), 0xD8));
+}
+
+AVX2 static inline __m256d _norm4_avx2(const double* p)
+{
+    __m256d a = _mm256_loadu_pd(p);
+    __m256d b = _mm256_loadu_pd(p + 4);
+    // n0 n2 n1 n3
+    __m256d h = _mm256_hadd_pd(_mm256_mul_pd(a, a), _mm256_mul_pd(b, b));
+    return _mm256_permute4x64_pd(h, 0xD8);
+}
+
+AVX2 static void _abs_f4_avx2(const float* input, size_t count, float* output)
+{
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        _mm256_storeu_ps(output + i, _mm256_sqrt_ps(_norm8_avx2(input + 2*i)));
+    }
+    _abs_scalar(input + 2*i, count - i, output + i);
+}
+
+AVX2 static void _norm_f4_avx2(const float* input, size_t count, float* output)
+{
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        _mm256_storeu_ps(output + i, _norm8_avx2(input + 2*i));
+    }
+    _norm_scalar(input + 2*i, count - i, output + i);
+}
+
+AVX2 static void _abs_f8_avx2(const double* input, size_t count, double* output)
+{
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        _mm256_storeu_pd(output + i, _mm256_sqrt_pd(_norm4_avx2(input + 2*i)));
+    }
+    _abs_scalar(input + 2*i, count - i, output + i);
+}
+
+AVX2 static void _norm_f8_avx2(const double* input, size_t count, double* output)
+{
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        _mm256_storeu_pd(output + i, _norm4_avx2(input + 2*i));
+    }
+    _norm_scalar(input + 2*i, count - i, output + i);
+}
+
+AVX2 static void _f4_to_f8_avx2(const float* input, size_t count, double* output)
+{
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 x = _mm256_loadu_ps(input + i);
+        _mm256_storeu_pd(output + i,     _mm256_cvtps_pd(_mm256_castps256_ps128(x)));
+        _mm256_storeu_pd(output + i + 4, _mm256_cvtps_pd(_mm256_extractf128_ps(x, 1)));
+    }
+    _convert_scalar(input + i, count - i, output + i);
+}
+
+AVX2 static void _f8_to_f4_avx2(const double* input, size_t count, float* output)
+{
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128 lo = _mm256_cvtpd_ps(_mm256_loadu_pd(input + i));
+        __m128 hi = _mm256_cvtpd_ps(_mm256_loadu_pd(input + i + 4));
+        _mm256_storeu_ps(output + i, _mm256_insertf128_ps(_mm256_castps128_ps256(lo), hi, 1));
+    }
+    _convert_scalar(input + i, count - i, output + i);
+}
+
+// nan lanes are zeroed and rounded to nearest even; cvtt gives INT_MIN out of
+// the range, so only the positive overflow is fixed up.
+AVX2 static void _f4_to_i4_avx2(const float* input, size_t count, int32_t* output)
+{
+    const __m256 limit = _mm256_set1_ps(2147483648.0f);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 x = _mm256_loadu_ps(input + i);
+        __m256 r = _mm256_round_ps(_mm256_and_ps(x, _mm256_cmp_ps(x, x, _CMP_ORD_Q)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        __m256i v = _mm256_cvttps_epi32(r);
+        v = _mm256_blendv_epi8(v, _mm256_set1_epi32(I4_MAX), _mm256_castps_si256(_mm256_cmp_ps(r, limit, _CMP_GE_OQ)));
+        _mm256_storeu_si256((__m256i*)(output + i), v);
+    }
+    _to_i4_scalar(input + i, count - i, output + i);
+}
+
+// int32 is exact in double, so the rounded value is clamped before cvtt.
+AVX2 static void _f8_to_i4_avx2(const double* input, size_t count, int32_t* output)
+{
+    const __m256d lo = _mm256_set1_pd(double(I4_MIN));
+    const __m256d hi = _mm256_set1_pd(double(I4_MAX));
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256d x = _mm256_loadu_pd(input + i);
+        __m256d r = _mm256_round_pd(_mm256_and_pd(x, _mm256_cmp_pd(x, x, _CMP_ORD_Q)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        _mm_storeu_si128((__m128i*)(output + i), _mm256_cvttpd_epi32(_mm256_min_pd(_mm256_max_pd(r, lo), hi)));
+    }
+    _to_i4_scalar(input + i, count - i, output + i);
+}
+
+AVX2 static inline __m256 _log_avx2(__m256 x)
+{
+    using namespace LogPoly;
+
+    __m256i xi = _mm256_castps_si256(x);
+    // exponent, and mantissa in [0.5, 1)
+    __m256 e = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_srli_epi32(xi, 23), _mm256_set1_epi32(126)));
+    x = _mm256_castsi256_ps(_mm256_or_si256(_mm256_and_si256(xi, _mm256_set1_epi32(0x007FFFFF)), _mm256_set1_epi32(0x3F000000)));
+
+    // fold the mantissa into [sqrt(0.5), sqrt(2)).
+    __m256 mask = _mm256_cmp_ps(x, _mm256_set1_ps(SQRTHF), _CMP_LT_OQ);
+    e = _mm256_sub_ps(e, _mm256_and_ps(mask, _mm256_set1_ps(1.0f)));
+    x = _mm256_add_ps(_mm256_sub_ps(x, _mm256_set1_ps(1.0f)), _mm256_and_ps(mask, x));
+
+    __m256 z = _mm256_mul_ps(x, x);
+    __m256 y = _mm256_set1_ps(P0);
+    y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(P1));
+    y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(P2));
+    y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(P3));
+    y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(P4));
+    y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(P5));
+    y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(P6));
+    y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(P7));
+    y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(P8));
+    y = _mm256_mul_ps(_mm256_mul_ps(y, x), z);
+
+    y = _mm256_fmadd_ps(e, _mm256_set1_ps(Q1), y);
+    y = _mm256_fnmadd_ps(z, _mm256_set1_ps(0.5f), y);
+    x = _mm256_add_ps(x, y);
+    return _mm256_fmadd_ps(e, _mm256_set1_ps(Q2), x);
+}
+
+AVX2 static void _log10_f4_avx2(const float* input, size_t count, float floor, float* output)
+{
+    const __m256 lo = _mm256_set1_ps(floor);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 v = _mm256_loadu_ps(input + i);
+        __m256 x = _mm256_max_ps(v, lo);
+        // nan, zero, negative, denormal and inf lanes take the scalar path.
+        __m256 odd = _mm256_or_ps(_mm256_cmp_ps(v, v, _CMP_UNORD_Q),
+                     _mm256_or_ps(_mm256_cmp_ps(x, _mm256_set1_ps(LogPoly::NORM_MIN), _CMP_NGE_UQ),
+                                  _mm256_cmp_ps(x, _mm256_set1_ps(LogPoly::INF), _CMP_EQ_OQ)));
+        if (_mm256_movemask_ps(odd) != 0) {
+            _log10_scalar(input + i, 8, floor, output + i);
+            continue;
+        }
+        _mm256_storeu_ps(output + i, _mm256_mul_ps(_log_avx2(x), _mm256_set1_ps(LogPoly::LOG10E)));
+    }
+    _log10_scalar(input + i, count - i, floor, output + i);
+}
+
+static const SimdKernels AVX2_KERNELS = {
+    "avx2",
+    _abs_f4_avx2,
+    _abs_f8_avx2,
+    _norm_f4_avx2,
+    _norm_f8_avx2,
+    _f4_to_f8_avx2,
+    _f8_to_f4_avx2,
+    _f4_to_i4_avx2,
+    _f8_to_i4_avx2,
+    _log10_f4_avx2
+};
+
+/***  Module Header  ******************************************************}}}*/
+/**
+* AVX-512 kernels
+* @par DESCRIPTION
+*   16 floats / 8 doubles per step. the complex pairs are split into re/im
+*   by the two-source permutation.
+*
+* @retval none
+**/
+/**************************************************************************{{{*/
+#define AVX512 __attribute__((target("avx512f")))
+
+AVX512 static inline __m512 _norm16_avx512(const float* p)
+{
+    const __m512i even = _mm512_set_epi32(30, 28, 26, 24, 22, 20, 18, 16, 14, 12, 10, 8, 6, 4, 2, 0);
+    const __m512i odd  = _mm512_set_epi32(31, 29, 27, 25, 23, 21, 19, 17, 15, 13, 11, 9, 7, 5, 3, 1);
+
+    __m512 a  = _mm512_loadu_ps(p);
+    __m512 b  = _mm512_loadu_ps(p + 16);
+    __m512 re = _mm512_permutex2var_ps(a, even, b);
+    __m512 im = _mm512_permutex2var_ps(a, odd,  b);
+    return _mm512_fmadd_ps(re, re, _mm512_mul_ps(im, im));
+}
+
+AVX512 static inline __m512d _norm8_avx512(const double* p)
+{
+    const __m512i even = _mm512_set_epi64(14, 12, 10, 8, 6, 4, 2, 0);
+    const __m512i odd  = _mm512_set_epi64(15, 13, 11, 9, 7, 5, 3, 1);
+
+    __m512d a  = _mm512_loadu_pd(p);
+    __m512d b  = _mm512_loadu_pd(p + 8);
+    __m512d re = _mm512_permutex2var_pd(a, even, b);
+    __m512d im = _mm512_permutex2var_pd(a, odd,  b);
+    return _mm512_fmadd_pd(re, re, _mm512_mul_pd(im, im));
+}
+
+AVX512 static void _abs_f4_avx512(const float* input, size_t count, float* output)
+{
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        _mm512_storeu_ps(output + i, _mm512_sqrt_ps(_norm16_avx512(input + 2*i)));
+    }
+    _abs_scalar(input + 2*i, count - i, output + i);
+}
+
+AVX512 static void _norm_f4_avx512(const float* input, size_t count, float* output)
+{
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        _mm512_storeu_ps(output + i, _norm16_avx512(input + 2*i));
+    }
+    _norm_scalar(input + 2*i, count - i, output + i);
+}
+
+AVX512 static void _abs_f8_avx512(const double* input, size_t count, double* output)
+{
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        _mm512_storeu_pd(output + i, _mm512_sqrt_pd(_norm8_avx512(input + 2*i)));
+    }
+    _abs_scalar(input + 2*i, count - i, output + i);
+}
+
+AVX512 static void _norm_f8_avx512(const double* input, size_t count, double* output)
+{
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        _mm512_storeu_pd(output + i, _norm8_avx512(input + 2*i));
+    }
+    _norm_scalar(input + 2*i, count - i, output + i);
+}
+
+AVX512 static void _f4_to_f8_avx512(const float* input, size_t count, double* output)
+{
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        _mm512_storeu_pd(output + i, _mm512_cvtps_pd(_mm256_loadu_ps(input + i)));
+    }
+    _convert_scalar(input + i, count - i, output + i);
+}
+
+AVX512 static void _f8_to_f4_avx512(const double* input, size_t count, float* output)
+{
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        _mm256_storeu_ps(output + i, _mm512_cvtpd_ps(_mm512_loadu_pd(input + i)));
+    }
+    _convert_scalar(input + i, count - i, output + i);
+}
+
+AVX512 static void _f4_to_i4_avx512(const float* input, size_t count, int32_t* output)
+{
+    const __m512 limit = _mm512_set1_ps(2147483648.0f);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m512 x = _mm512_loadu_ps(input + i);
+        __m512 r = _mm512_roundscale_ps(_mm512_maskz_mov_ps(_mm512_cmp_ps_mask(x, x, _CMP_ORD_Q), x), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        __m512i v = _mm512_cvttps_epi32(r);
+        v = _mm512_mask_mov_epi32(v, _mm512_cmp_ps_mask(r, limit, _CMP_GE_OQ), _mm512_set1_epi32(I4_MAX));
+        _mm512_storeu_si512(output + i, v);
+    }
+    _to_i4_scalar(input + i, count - i, output + i);
+}
+
+AVX512 static void _f8_to_i4_avx512(const double* input, size_t count, int32_t* output)
+{
+    const __m512d lo = _mm512_set1_pd(double(I4_MIN));
+    const __m512d hi = _mm512_set1_pd(double(I4_MAX));
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m512d x = _mm512_loadu_pd(input + i);
+        __m512d r = _mm512_roundscale_pd(_mm512_maskz_mov_pd(_mm512_cmp_pd_mask(x, x, _CMP_ORD_Q), x), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        _mm256_storeu_si256((__m256i*)(output + i), _mm512_cvttpd_epi32(_mm512_min_pd(_mm512_max_pd(r, lo), hi)));
+    }
+    _to_i4_scalar(input + i, count - i, output + i);
+}
+
+AVX512 static inline __m512 _log_avx512(__m512 x)
+{
+    using namespace LogPoly;
+
+    __m512i xi = _mm512_castps_si512(x);
+    __m512 e = _mm512_cvtepi32_ps(_mm512_sub_epi32(_mm512_srli_epi32(xi, 23), _mm512_set1_epi32(126)));
+    x = _mm512_castsi512_ps(_mm512_or_si512(_mm512_and_si512(xi, _mm512_set1_epi32(0x007FFFFF)), _mm512_set1_epi32(0x3F000000)));
+
+    __mmask16 mask = _mm512_cmp_ps_mask(x, _mm512_set1_ps(SQRTHF), _CMP_LT_OQ);
+    e = _mm512_mask_sub_ps(e, mask, e, _mm512_set1_ps(1.0f));
+    x = _mm512_mask_add_ps(_mm512_sub_ps(x, _mm512_set1_ps(1.0f)), mask, _mm512_sub_ps(x, _mm512_set1_ps(1.0f)), x);
+
+    __m512 z = _mm512_mul_ps(x, x);
+    __m512 y = _mm512_set1_ps(P0);
+    y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(P1));
+    y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(P2));
+    y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(P3));
+    y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(P4));
+    y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(P5));
+    y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(P6));
+    y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(P7));
+    y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(P8));
+    y = _mm512_mul_ps(_mm512_mul_ps(y, x), z);
+
+    y = _mm512_fmadd_ps(e, _mm512_set1_ps(Q1), y);
+    y = _mm512_fnmadd_ps(z, _mm512_set1_ps(0.5f), y);
+    x = _mm512_add_ps(x, y);
+    return _mm512_fmadd_ps(e, _mm512_set1_ps(Q2), x);
+}
+
+AVX512 static void _log10_f4_avx512(const float* input, size_t count, float floor, float* output)
+{
+    const __m512 lo = _mm512_set1_ps(floor);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m512 v = _mm512_loadu_ps(input + i);
+        __m512 x = _mm512_max_ps(v, lo);
+        // nan, zero, negative, denormal and inf lanes take the scalar path.
+        __mmask16 odd = _mm512_cmp_ps_mask(v, v, _CMP_UNORD_Q)
+                      | _mm512_cmp_ps_mask(x, _mm512_set1_ps(LogPoly::NORM_MIN), _CMP_NGE_UQ)
+                      | _mm512_cmp_ps_mask(x, _mm512_set1_ps(LogPoly::INF), _CMP_EQ_OQ);
+        if (odd != 0) {
+            _log10_scalar(input + i, 16, floor, output + i);
+            continue;
+        }
+        _mm512_storeu_ps(output + i, _mm512_mul_ps(_log_avx512(x), _mm512_set1_ps(LogPoly::LOG10E)));
+    }
+    _log10_scalar(input + i, count - i, floor, output + i);
+}
+
+static const SimdKernels AVX512_KERNELS = {
+    "avx512",
+    _abs_f4_avx512,
+    _abs_f8_avx512,
+    _norm_f4_avx512,
+    _norm_f8_avx512,
+    _f4_to_f8_avx512,
+    _f8_to_f4_avx512,
+    _f4_to_i4_avx512,
+    _f8_to_i4_avx512,
+    _log10_f4_avx512
+};
+#endif
+
+#ifdef MOZU_SIMD_NEON
+/***  Module Header  ******************************************************}}}*/
+/**
+* NEON kernels
+* @par DESCRIPTION
+*   4 floats / 2 doubles per step. NEON is always present on aarch64, and
+*   the structure load splits the complex pairs into re/im.
+*
+* @retval none
+**/
+/**************************************************************************{{{*/
+static void _abs_f4_neon(const float* input, size_t count, float* output)
+{
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        float32x4x2_t c = vld2q_f32(input + 2*i);
+        vst1q_f32(output + i, vsqrtq_f32(vfmaq_f32(vmulq_f32(c.val[1], c.val[1]), c.val[0], c.val[0])));
+    }
+    _abs_scalar(input + 2*i, count - i, output + i);
+}
+
+static void _norm_f4_neon(const float* input, size_t count, float* output)
+{
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        float32x4x2_t c = vld2q_f32(input + 2*i);
+        vst1q_f32(output + i, vfmaq_f32(vmulq_f32(c.val[1], c.val[1]), c.val[0], c.val[0]));
+    }
+    _norm_scalar(input + 2*i, count - i, output + i);
+}
+
+static void _abs_f8_neon(const double* input, size_t count, double* output)
+{
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        float64x2x2_t c = vld2q_f64(input + 2*i);
+        vst1q_f64(output + i, vsqrtq_f64(vfmaq_f64(vmulq_f64(c.val[1], c.val[1]), c.val[0], c.val[0])));
+    }
+    _abs_scalar(input + 2*i, count - i, output + i);
+}
+
+static void _norm_f8_neon(const double* input, size_t count, double* output)
+{
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        float64x2x2_t c = vld2q_f64(input + 2*i);
+        vst1q_f64(output + i, vfmaq_f64(vmulq_f64(c.val[1], c.val[1]), c.val[0], c.val[0]));
+    }
+    _norm_scalar(input + 2*i, count - i, output + i);
+}
+
+static void _f4_to_f8_neon(const float* input, size_t count, double* output)
+{
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        float32x4_t x = vld1q_f32(input + i);
+        vst1q_f64(output + i,     vcvt_f64_f32(vget_low_f32(x)));
+        vst1q_f64(output + i + 2, vcvt_high_f64_f32(x));
+    }
+    _convert_scalar(input + i, count - i, output + i);
+}
+
+static void _f8_to_f4_neon(const double* input, size_t count, float* output)
+{
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        float32x2_t lo = vcvt_f32_f64(vld1q_f64(input + i));
+        vst1q_f32(output + i, vcvt_high_f32_f64(lo, vld1q_f64(input + i + 2)));
+    }
+    _convert_scalar(input + i, count - i, output + i);
+}
+
+// fcvtn rounds to nearest even and saturates; nan becomes 0.
+static void _f4_to_i4_neon(const float* input, size_t count, int32_t* output)
+{
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        vst1q_s32(output + i, vcvtnq_s32_f32(vld1q_f32(input + i)));
+    }
+    _to_i4_scalar(input + i, count - i, output + i);
+}
+
+static void _f8_to_i4_neon(const double* input, size_t count, int32_t* output)
+{
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        int32x2_t lo = vqmovn_s64(vcvtnq_s64_f64(vld1q_f64(input + i)));
+        int32x2_t hi = vqmovn_s64(vcvtnq_s64_f64(vld1q_f64(input + i + 2)));
+        vst1q_s32(output + i, vcombine_s32(lo, hi));
+    }
+    _to_i4_scalar(input + i, count - i, output + i);
+}
+
+static inline float32x4_t _log_neon(float32x4_t x)
+{
+    using namespace LogPoly;
+
+    int32x4_t xi = vreinterpretq_s32_f32(x);
+    float32x4_t e = vcvtq_f32_s32(vsubq_s32(vshrq_n_s32(xi, 23), vdupq_n_s32(126)));
+    x = vreinterpretq_f32_s32(vorrq_s32(vandq_s32(xi, vdupq_n_s32(0x007FFFFF)), vdupq_n_s32(0x3F000000)));
+
+    uint32x4_t mask = vcltq_f32(x, vdupq_n_f32(SQRTHF));
+    e = vsubq_f32(e, vreinterpretq_f32_u32(vandq_u32(mask, vreinterpretq_u32_f32(vdupq_n_f32(1.0f)))));
+    x = vaddq_f32(vsubq_f32(x, vdupq_n_f32(1.0f)), vreinterpretq_f32_u32(vandq_u32(mask, vreinterpretq_u32_f32(x))));
+
+    float32x4_t z = vmulq_f32(x, x);
+    float32x4_t y = vdupq_n_f32(P0);
+    y = vfmaq_f32(vdupq_n_f32(P1), y, x);
+    y = vfmaq_f32(vdupq_n_f32(P2), y, x);
+    y = vfmaq_f32(vdupq_n_f32(P3), y, x);
+    y = vfmaq_f32(vdupq_n_f32(P4), y, x);
+    y = vfmaq_f32(vdupq_n_f32(P5), y, x);
+    y = vfmaq_f32(vdupq_n_f32(P6), y, x);
+    y = vfmaq_f32(vdupq_n_f32(P7), y, x);
+    y = vfmaq_f32(vdupq_n_f32(P8), y, x);
+    y = vmulq_f32(vmulq_f32(y, x), z);
+
+    y = vfmaq_f32(y, e, vdupq_n_f32(Q1));
+    y = vfmsq_f32(y, z, vdupq_n_f32(0.5f));
+    x = vaddq_f32(x, y);
+    return vfmaq_f32(x, e, vdupq_n_f32(Q2));
+}
+
+static void _log10_f4_neon(const float* input, size_t count, float floor, float* output)
+{
+    const float32x4_t lo = vdupq_n_f32(floor);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        float32x4_t v = vld1q_f32(input + i);
+        float32x4_t x = vmaxq_f32(v, lo);
+        // nan, zero, negative, denormal and inf lanes take the scalar path.
+        uint32x4_t normal = vandq_u32(vceqq_f32(v, v),
+                            vandq_u32(vcgeq_f32(x, vdupq_n_f32(LogPoly::NORM_MIN)),
+                                      vcltq_f32(x, vdupq_n_f32(LogPoly::INF))));
+        if (vminvq_u32(normal) == 0) {
+            _log10_scalar(input + i, 4, floor, output + i);
+            continue;
+        }
+        vst1q_f32(output + i, vmulq_f32(_log_neon(x), vdupq_n_f32(LogPoly::LOG10E)));
+    }
+    _log10_scalar(input + i, count - i, floor, output + i);
+}
+
+static const SimdKernels NEON_KERNELS = {
+    "neon",
+    _abs_f4_neon,
+    _abs_f8_neon,
+    _norm_f4_neon,
+    _norm_f8_neon,
+    _f4_to_f8_neon,
+    _f8_to_f4_neon,
+    _f4_to_i4_neon,
+    _f8_to_i4_neon,
+    _log10_f4_neon
+};
+#endif
+
+/***  Module Header  ******************************************************}}}*/
+/**
+* kernel dispatcher
+* @par DESCRIPTION
+*   The kernels start as scalar. simd_init() probes the CPU once at NIF
+*   load, before any NIF runs, and switches to the best supported ones;
+*   after that the supported list is only read. The candidates are listed
+*   in order of preference.
+*
+* @retval selected kernels, or NULL
+**/
+/**************************************************************************{{{*/
+std::atomic<const SimdKernels*> g_simd(&SCALAR);
+
+static const SimdKernels* _candidates[] = {
+#ifdef MOZU_SIMD_X86
+    &AVX512_KERNELS,
+    &AVX2_KERNELS,
+#endif
+#ifdef MOZU_SIMD_NEON
+    &NEON_KERNELS,
+#endif
+    &SCALAR
+};
+
+// NULL terminated kernels supported by the CPU, in order of preference.
+static const SimdKernels* _supported[sizeof(_candidates)/sizeof(_candidates[0]) + 1] = { &SCALAR, NULL };
+static const char*        _supported_names[sizeof(_candidates)/sizeof(_candidates[0]) + 1] = { "scalar", NULL };
+
+static bool _cpu_supports(const SimdKernels* kernels)
+{
+#ifdef MOZU_SIMD_X86
+    __builtin_cpu_init();
+    if (kernels == &AVX512_KERNELS) {
+        return __builtin_cpu_supports("avx512f");
+    }
+    if (kernels == &AVX2_KERNELS) {
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    }
+#endif
+    return true;
+}
+
+void simd_init()
+{
+    size_t n = 0;
+    for (const SimdKernels* kernels : _candidates) {
+        if (_cpu_supports(kernels)) {
+            _supported[n]       = kernels;
+            _supported_names[n] = kernels->name;
+            n++;
+        }
+    }
+    _supported[n]       = NULL;
+    _supported_names[n] = NULL;
+
+    simd_select();
+}
+
+const SimdKernels* simd_select(const char* name)
+{
+    for (const SimdKernels* const* kernels = _supported; *kernels != NULL; kernels++) {
+        if (name == NULL || std::strcmp(name, (*kernels)->name) == 0) {
+            g_simd.store(*kernels);
+            return *kernels;
+        }
+    }
+    return NULL;
+}
+
+const char* const* simd_supported()
+{
+    return _supported_names;
+}
+
+/***  Module Header  ******************************************************}}}*/
+/**
+* Select SIMD kernels
+* @par DESCRIPTION
+*   Switch the elementwise kernels to :scalar, :avx2, :avx512, :neon or the
+*   best one (:auto). It is meant for benchmarks and troubleshooting.
+*
+* @retval {:ok, selected}
+**/
+/**************************************************************************{{{*/
+DECL_NIF(simd_backend) {
+    char name[16];
+
+    if (ality != 1
+    || !enif_get_atom(env, term[0], name, sizeof(name), ERL_NIF_LATIN1)) {
+        return enif_make_badarg(env);
+    }
+
+    const SimdKernels* kernels = simd_select((std::strcmp(name, "auto") == 0) ? NULL : name);
+    if (kernels == NULL) {
+        return enif_make_badarg(env);
+    }
+
+    return enif_make_ok(env, enif_make_atom(env, kernels->name));
+}
+
+/***  Module Header  ******************************************************}}}*/
+/**
+* SIMD kernels info
+* @par DESCRIPTION
+*   The kernels in use and the ones supported by the CPU.
+*
+* @retval {:ok, current, [supported]}
+**/
+/**************************************************************************{{{*/
+DECL_NIF(simd_info) {
+    if (ality != 0) {
+        return enif_make_badarg(env);
+    }
+
+    ERL_NIF_TERM supported[8];
+    unsigned n = 0;
+    for (const char* const* names = simd_supported(); *names != NULL; names++) {
+        supported[n++] = enif_make_atom(env, *names);
+    }
+
+    return enif_make_tuple3(env,
+             enif_make_ok(env),
+             enif_make_atom(env, simd().name),
+             enif_make_list_from_array(env, supported, n));
+}
+
+/*** simd.cc *************************************************************}}}*/
@@ -0,0 +1,65 @@
+/***  File Header  ************************************************************/
+/**
+* simd.h
+*
+* Elixir/Erlang Port ext. of Post-processing for DNN.
+* @author   Shozo Fukuda
+* @date     create 2026-10-17 20:05:31
+* System    Windows10, WSL2/Ubuntu 20.04.2<br>
+*
+**/
+/**************************************************************************{{{*/
+#ifndef _SIMD_H
+#define _SIMD_H
+
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+
+/***  Class Header  *******************************************************}}}*/
+/**
+* elementwise kernels
+* @par description
+*   table of the elementwise kernels for one instruction set: scalar, AVX2,
+*   AVX-512 (x86) or NEON (aarch64). the complex input is interleaved re/im
+*   of count elements; the output may overlay the input (in place).
+*   the table is selected after the CPU features at NIF load.
+**/
+/**************************************************************************{{{*/
+struct SimdKernels {
+    const char* name;
+
+    void (*abs_f4)(const float* input, size_t count, float* output);
+    void (*abs_f8)(const double* input, size_t count, double* output);
+    void (*norm_f4)(const float* input, size_t count, float* output);
+    void (*norm_f8)(const double* input, size_t count, double* output);
+
+    void (*f4_to_f8)(const float* input, size_t count, double* output);
+    void (*f8_to_f4)(const double* input, size_t count, float* output);
+    // round to nearest even and saturate; nan becomes 0.
+    void (*f4_to_i4)(const float* input, size_t count, int32_t* output);
+    void (*f8_to_i4)(const double* input, size_t count, int32_t* output);
+
+    // log10(max(x, floor)); nan, zero, denormal and inf come out as std::log10 gives.
+    void (*log10_f4)(const float* input, size_t count, float floor, float* output);
+};
+
+extern std::atomic<const SimdKernels*> g_simd;
+
+// probe the CPU and select the best kernels; once at NIF load.
+void simd_init();
+
+// select the kernels by name ("scalar", "avx2", "avx512", "neon"), or the
+// best one supported by the CPU for NULL. return NULL if not supported.
+const SimdKernels* simd_select(const char* name=NULL);
+
+// NULL terminated names of the kernels supported by the CPU.
+const char* const* simd_supported();
+
+inline const SimdKernels& simd()
+{
+    return *g_simd.load(std::memory_order_relaxed);
+}
+
+#endif
+/*** simd.h **************************************************************}}}*/
@@ -0,0 +1,338 @@
+/***  File Header  ************************************************************/
+/**
+* thread_pool.cc
+*
+* Elixir/Erlang Port ext. of Post-processing for DNN.
+* @author   Shozo Fukuda
+* @date     create 2026-10-17 23:02:17
+* System    Windows10, WSL2/Ubuntu 20.04.2<br>
+*
+**/
+/**************************************************************************{{{*/
+
+#include "my_erl_nif.h"
+#include <algorithm>
+#include "thread_pool.h"
+
+// the pool and queue of the worker thread (none on the other threads).
+static thread_local const ThreadPool* t_pool  = nullptr;
+static thread_local size_t            t_index = 0;
+// the pool the thread is counted busy on as a caller or a seated runner.
+static thread_local const ThreadPool* t_seat  = nullptr;
+
+static std::mutex                  s_mutex;
+static std::shared_ptr<ThreadPool> s_pool;
+static unsigned                    s_default = 0;
+
+/***  Module Header  ******************************************************}}}*/
+/**
+* thread pool
+* @par DESCRIPTION
+*   Start size-1 workers, each with its own queue.
+**/
+/**************************************************************************{{{*/
+ThreadPool::ThreadPool(unsigned size)
+: m_queued(0), m_busy(0), m_deal(0), m_stop(false)
+{
+    const unsigned n_workers = std::max(size, 1u) - 1;
+
+    for (unsigned i = 0; i < n_workers; i++) {
+        m_queues.emplace_back(new Queue);
+    }
+    for (unsigned i = 0; i < n_workers; i++) {
+        m_workers.emplace_back(&ThreadPool::worker, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+
+    for (auto& thread : m_workers) {
+        thread.join();
+    }
+}
+
+/***  Module Header  ******************************************************}}}*/
+/**
+* run
+* @par DESCRIPTION
+*   Cut [0, count) into about 4 blocks per thread, deal all but the first
+*   to the queues, run the first here and then help with any queued block
+*   until the job is done. The caller is counted busy meanwhile, so that the
+*   workers only make up the rest of the pool size.
+**/
+/**************************************************************************{{{*/
+void ThreadPool::run(size_t count, size_t grain, const Body& body)
+{
+    if (m_queues.empty()) {
+        body(0, count);
+        return;
+    }
+
+    const size_t n_split  = 4*size();
+    const size_t block    = std::max(std::max(grain, size_t(1)), (count + n_split - 1)/n_split);
+    const size_t n_blocks = (count + block - 1)/block;
+
+    Job job;
+    job.body    = &body;
+    job.pending = n_blocks;
+
+    const bool counted = (t_pool == this || t_seat == this);
+    if (!counted) {
+        enter();
+    }
+
+    const size_t home = (t_pool == this) ? t_index : m_deal.fetch_add(1);
+    for (size_t b = 1; b < n_blocks; b++) {
+        Queue& queue = *m_queues[(home + b) % m_queues.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back({&job, b*block, std::min(count, (b + 1)*block)});
+    }
+    if (n_blocks > 1) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_queued += n_blocks - 1;
+        }
+        m_wake.notify_all();
+        m_done.notify_all();
+    }
+
+    execute({&job, 0, std::min(count, block)});
+
+    while (job.pending.load() > 0) {
+        Task task;
+        if (pop(home, task)) {
+            execute(task);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_done.wait(lock, [&]{ return job.pending.load() == 0 || m_queued.load() > 0; });
+    }
+
+    if (!counted) {
+        leave();
+    }
+}
+
+/***  Module Header  ******************************************************}}}*/
+/**
+* pop a task
+* @par DESCRIPTION
+*   Take the newest block of the home queue, or steal the oldest block of
+*   another queue.
+*
+* @retval true if a task is taken
+**/
+/**************************************************************************{{{*/
+bool ThreadPool::pop(size_t home, Task& task)
+{
+    const size_t n_queues = m_queues.size();
+
+    for (size_t i = 0; i < n_queues; i++) {
+        Queue& queue = *m_queues[(home + i) % n_queues];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty()) {
+            continue;
+        }
+
+        if (i == 0) {
+            task = queue.tasks.back();
+            queue.tasks.pop_back();
+        }
+        else {
+            task = queue.tasks.front();
+            queue.tasks.pop_front();
+        }
+        m_queued--;
+        return true;
+    }
+
+    return false;
+}
+
+void ThreadPool::execute(const Task& task)
+{
+    (*task.job->body)(task.begin, task.end);
+
+    // the job lives on the caller's stack: no access after the last block.
+    if (task.job->pending.fetch_sub(1) == 1) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_done.notify_all();
+    }
+}
+
+void ThreadPool::worker(size_t index)
+{
+    t_pool  = this;
+    t_index = index;
+
+    for (;;) {
+        if (acquire()) {
+            Task task;
+            bool taken = pop(index, task);
+            if (taken) {
+                execute(task);
+            }
+            release();
+            if (taken) {
+                continue;
+            }
+        }
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_wake.wait(lock, [&]{ return m_stop || (m_queued.load() > 0 && m_busy.load() < long(size())); });
+        if (m_stop && m_queued.load() <= 0) {
+            return;
+        }
+    }
+}
+
+/***  Module Header  ******************************************************}}}*/
+/**
+* busy threads
+* @par DESCRIPTION
+*   A worker takes a seat only while fewer than size threads are busy; the
+*   callers and the seated runners are busy anyway and always counted. A
+*   seat given back wakes a worker for the blocks still queued.
+*
+* @retval true if the worker may take a block
+**/
+/**************************************************************************{{{*/
+bool ThreadPool::acquire()
+{
+    long busy = m_busy.load();
+    while (busy < long(size())) {
+        if (m_busy.compare_exchange_weak(busy, busy + 1)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::release()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_busy--;
+    }
+    m_wake.notify_one();
+}
+
+void ThreadPool::enter()
+{
+    m_busy++;
+    t_seat = this;
+}
+
+void ThreadPool::leave()
+{
+    t_seat = nullptr;
+    release();
+}
+
+ThreadPool::Seat::Seat()
+: m_pool(ThreadPool::get()), m_seated(false)
+{
+    if (m_pool && t_seat != m_pool.get() && t_pool != m_pool.get()) {
+        m_pool->enter();
+        m_seated = true;
+    }
+}
+
+ThreadPool::Seat::~Seat()
+{
+    if (m_seated) {
+        m_pool->leave();
+    }
+}
+
+/***  Module Header  ******************************************************}}}*/
+/**
+* process-wide pool
+* @par DESCRIPTION
+*   The pool is replaced as a whole; the calls still running keep the old
+*   one alive until they return. The default size is the number of dirty
+*   CPU schedulers given at load.
+**/
+/**************************************************************************{{{*/
+void ThreadPool::start(unsigned size)
+{
+    if (size == 0) {
+        size = (s_default > 0) ? s_default : std::thread::hardware_concurrency();
+    }
+
+    std::shared_ptr<ThreadPool> pool(new ThreadPool(size));
+
+    std::lock_guard<std::mutex> lock(s_mutex);
+    s_pool.swap(pool);
+}
+
+void ThreadPool::set_default(unsigned size)
+{
+    s_default = size;
+}
+
+void ThreadPool::stop()
+{
+    std::shared_ptr<ThreadPool> pool;
+
+    std::lock_guard<std::mutex> lock(s_mutex);
+    s_pool.swap(pool);
+}
+
+std::shared_ptr<ThreadPool> ThreadPool::get()
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+    return s_pool;
+}
+
+/***  Module Header  ******************************************************}}}*/
+/**
+* resize thread pool
+* @par DESCRIPTION
+*   Replace the process-wide pool by one of size threads (the caller
+*   included), 0 for the number of dirty CPU schedulers. 1 runs every kernel on the
+*   calling scheduler alone.
+*
+* @retval {:ok, size}
+**/
+/**************************************************************************{{{*/
+DECL_NIF(thread_pool) {
+    unsigned size;
+
+    if (ality != 1
+    || !enif_get_uint(env, term[0], &size)) {
+        return enif_make_badarg(env);
+    }
+
+    ThreadPool::start(size);
+
+    return enif_make_ok(env, enif_make_uint(env, ThreadPool::get()->size()));
+}
+
+/***  Module Header  ******************************************************}}}*/
+/**
+* thread pool info
+* @par DESCRIPTION
+*   The number of threads of the pool, the caller included.
+*
+* @retval {:ok, size}
+**/
+/**************************************************************************{{{*/
+DECL_NIF(thread_pool_info) {
+    if (ality != 0) {
+        return enif_make_badarg(env);
+    }
+
+    std::shared_ptr<ThreadPool> pool = ThreadPool::get();
+
+    return enif_make_ok(env, enif_make_uint(env, pool ? pool->size() : 1));
+}
+
+/*** thread_pool.cc ******************************************************}}}*/
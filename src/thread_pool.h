@@ -0,0 +1,134 @@
+/***  File Header  ************************************************************/
+/**
+* thread_pool.h
+*
+* Elixir/Erlang Port ext. of Post-processing for DNN.
+* @author   Shozo Fukuda
+* @date     create 2026-10-17 23:02:17
+* System    Windows10, WSL2/Ubuntu 20.04.2<br>
+*
+**/
+/**************************************************************************{{{*/
+#ifndef _THREAD_POOL_H
+#define _THREAD_POOL_H
+
+#include <cstddef>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+/***  Class Header  *******************************************************}}}*/
+/**
+* work-stealing thread pool
+* @par description
+*   process-wide pool of size-1 worker threads; the thread calling run()
+*   counts as the last one. run() cuts the range into blocks dealt to the
+*   per worker queues, and works on blocks itself until its job is done.
+*   a worker pops its own queue from the back and steals from the front of
+*   the others, so a nested run() (e.g. a clip of a batch splitting its
+*   frames) never blocks the pool.
+*   the pool is created at NIF load with the number of dirty CPU
+*   schedulers by default: they share the same workers rather than
+*   spawning threads per call. the callers in run(), the job runners in a
+*   Seat and the workers on a block are counted as busy, and a worker takes
+*   no block while size threads are busy, so the kernels never run on more
+*   threads than the pool size. the body must not throw.
+**/
+/**************************************************************************{{{*/
+class ThreadPool {
+public:
+    typedef std::function<void(size_t, size_t)> Body;
+
+    explicit ThreadPool(unsigned size);
+    ~ThreadPool();
+
+    unsigned size() const { return unsigned(m_workers.size()) + 1; }
+
+    // body(begin, end) over [0, count) in blocks of grain items at least.
+    void run(size_t count, size_t grain, const Body& body);
+
+    // the calling thread counted as busy on the pool while in scope.
+    class Seat {
+    public:
+        Seat();
+        ~Seat();
+    private:
+        std::shared_ptr<ThreadPool> m_pool;
+        bool                        m_seated;
+    };
+
+    // (re)create the process-wide pool of size threads, 0 for the default.
+    static void start(unsigned size);
+    static void set_default(unsigned size);
+    static void stop();
+    static std::shared_ptr<ThreadPool> get();
+
+protected:
+    struct Job {
+        const Body*         body;
+        std::atomic<size_t> pending;
+    };
+
+    struct Task {
+        Job*   job;
+        size_t begin;
+        size_t end;
+    };
+
+    struct Queue {
+        std::mutex       mutex;
+        std::deque<Task> tasks;
+    };
+
+    bool pop(size_t home, Task& task);
+    void execute(const Task& task);
+    void worker(size_t index);
+    bool acquire();
+    void release();
+    void enter();
+    void leave();
+
+    std::vector<std::unique_ptr<Queue>> m_queues;
+    std::vector<std::thread>            m_workers;
+    std::mutex                          m_mutex;
+    std::condition_variable             m_wake;     // workers: tasks queued or stop
+    std::condition_variable             m_done;     // callers: tasks queued or job done
+    std::atomic<long>                   m_queued;
+    std::atomic<long>                   m_busy;     // callers, seated runners and workers on a block
+    std::atomic<size_t>                 m_deal;     // round robin of non worker callers
+    bool                                m_stop;
+};
+
+/***  Module Header  ******************************************************}}}*/
+/**
+* parallel for
+* @par DESCRIPTION
+*   Run body(begin, end) over [0, count) on the process-wide pool, or on
+*   the calling thread alone for count <= grain or without the pool.
+*
+* @retval none
+**/
+/**************************************************************************{{{*/
+template <typename F>
+void parallel_for(size_t count, size_t grain, F body)
+{
+    if (count == 0) {
+        return;
+    }
+
+    std::shared_ptr<ThreadPool> pool = (count > grain) ? ThreadPool::get() : nullptr;
+    if (pool && pool->size() > 1) {
+        pool->run(count, grain, body);
+    }
+    else {
+        body(0, count);
+    }
+}
+
+#endif
+/*** thread_pool.h *******************************************************}}}*/
@@ -0,0 +1,69 @@
+defmodule Mozu.AsyncTest do
+  # the job queue is configured process-wide.
+  use ExUnit.Case, async: false
+  import Mozu.TestHelper
+  alias Mozu.{Async, FeatureExtractor}
+
+  setup do
+    on_exit(fn -> Async.configure(runners: 2, capacity: 64) end)
+    {:ok, fe: FeatureExtractor.new(n_fft: 400, hop: 160, n_mels: 80)}
+  end
+
+  test "sends the same result as the synchronous call", %{fe: fe} do
+    audio = audio(signal(16000))
+    {:ok, job} = Async.log_mel_spectrogram(fe, audio, dtype: "<f4")
+    ref = job.ref
+
+    assert_receive {:mozu_result, ^ref, result}, 5000
+    assert Async.decode(job, result) == {:ok, FeatureExtractor.log_mel_spectrogram(fe, audio, true, "<f4")}
+  end
+
+  test "await gives the decoded result", %{fe: fe} do
+    audio = audio(signal(8000))
+    {:ok, job} = Async.mfcc(fe, audio)
+
+    assert Async.await(job, 5000) == {:ok, FeatureExtractor.mfcc(fe, audio)}
+  end
+
+  test "no result comes after cancel", %{fe: fe} do
+    Async.configure(runners: 1)
+    long = audio(signal(16000*30))
+
+    jobs = for _ <- 1..3, do: elem(Async.log_mel_spectrogram(fe, long), 1)
+
+    # the first is running, the others are queued.
+    for job <- jobs, do: assert Async.cancel(job) == :ok
+    for %{ref: ref} <- jobs, do: refute_receive {:mozu_result, ^ref, _}, 200
+  end
+
+  test "a full queue refuses the job", %{fe: fe} do
+    Async.configure(runners: 1, capacity: 1)
+    long = audio(signal(16000*30))
+
+    results = for _ <- 1..4, do: Async.log_mel_spectrogram(fe, long)
+
+    assert {:error, :busy} in results
+    for {:ok, job} <- results, do: Async.cancel(job)
+  end
+
+  test "invalid arguments raise at submit" do
+    assert_raise ArgumentError, fn -> Async.submit(:astype, [f32([1.0]), "<f4", "<x9"]) end
+    assert_raise ArgumentError, fn -> Async.submit(:wav_open, []) end
+  end
+
+  test "failures while running come back as errors" do
+    {:ok, job} = Async.load("/nonexistent/mozu.wav")
+
+    assert Async.await(job, 5000) == {:error, :invalid_wav}
+  end
+
+  test "reconfiguring keeps the runners asked for" do
+    for _ <- 1..20 do
+      Async.configure(runners: 6)
+      Async.configure(runners: 1)
+    end
+    Async.configure(runners: 3, capacity: 16)
+
+    assert {:ok, {_, _, 3, 16}} = Async.info()
+  end
+end
@@ -0,0 +1,220 @@
+defmodule Mozu.AudioTest do
+  use ExUnit.Case, async: true
+  import Mozu.TestHelper
+  alias Mozu.Audio
+
+  @moduletag :tmp_dir
+
+  # 3 channels of distinct signals, interleaved.
+  defp stereo3(n_frames) do
+    [signal(n_frames, 1), signal(n_frames, 2), signal(n_frames, 3)]
+    |> Enum.zip_with(& &1)
+    |> List.flatten()
+    |> then(&%Audio{channels: 3, sampling: 16000, wave: f32(&1)})
+  end
+
+  # frames [offset, offset+count) of the 3 channel audio.
+  defp frames_of(%Audio{wave: wave}, offset, count), do: binary_part(wave, offset*3*4, count*3*4)
+
+  defp wav_file(dir, audio, opts \\ []) do
+    path = Path.join(dir, "test.wav")
+    :ok = Audio.save(audio, path, opts)
+    path
+  end
+
+  describe "Audio.Reader" do
+    setup %{tmp_dir: dir} do
+      path = wav_file(dir, stereo3(10_000))
+      {:ok, audio} = Audio.load(path)
+      {:ok, path: path, audio: audio}
+    end
+
+    test "reads the whole file chunk by chunk", %{path: path, audio: audio} do
+      {:ok, reader} = Audio.Reader.open(path)
+
+      assert {reader.channels, reader.sampling, reader.length} == {3, 16000, 10_000}
+
+      chunks = Stream.repeatedly(fn -> Audio.Reader.read_chunk(reader, 3000) end)
+               |> Enum.take_while(&(&1 != :eof))
+      assert Enum.map(chunks, fn {:ok, chunk} -> Audio.length(chunk) end) == [3000, 3000, 3000, 1000]
+      assert Enum.map_join(chunks, fn {:ok, chunk} -> chunk.wave end) == audio.wave
+
+      Audio.Reader.close(reader)
+    end
+
+    test "reads from the frame it seeks to", %{path: path, audio: audio} do
+      {:ok, reader} = Audio.Reader.open(path)
+
+      assert Audio.Reader.seek(reader, 7000) == :ok
+      {:ok, chunk} = Audio.Reader.read_chunk(reader, 500)
+      assert chunk.wave == frames_of(audio, 7000, 500)
+
+      assert Audio.Reader.seek(reader, 0) == :ok
+      {:ok, chunk} = Audio.Reader.read_chunk(reader, 10)
+      assert chunk.wave == frames_of(audio, 0, 10)
+
+      assert Audio.Reader.seek(reader, 10_000) == :ok
+      assert Audio.Reader.read_chunk(reader, 10) == :eof
+
+      Audio.Reader.close(reader)
+    end
+
+    test "streams the same wave", %{path: path, audio: audio} do
+      assert Audio.Reader.stream(path, 1024) |> Enum.map_join(& &1.wave) == audio.wave
+    end
+  end
+
+  describe "decode/encode" do
+    test "decodes the same as loading the file", %{tmp_dir: dir} do
+      {:ok, image} = Audio.encode(stereo3(4000))
+      path = Path.join(dir, "image.wav")
+      File.write!(path, image)
+
+      assert Audio.decode(image) == Audio.load(path)
+    end
+
+    test "round trips the wave in float32" do
+      audio = stereo3(4000)
+      {:ok, image} = Audio.encode(audio, format: :f32)
+
+      assert Audio.decode(image) == {:ok, audio}
+    end
+
+    test "rejects an image that is not WAV" do
+      assert Audio.decode("RIFF but not really a wave") == {:error, :invalid_wav}
+    end
+  end
+
+  describe "pad" do
+    # mode 0, 1, 2 of the NIF.
+    for {mode, name} <- [{0, :zero}, {1, :edge}, {2, :reflect}] do
+      test "pads like numpy.pad #{name}" do
+        x = to_list(npy(signal(50)))
+
+        for {front, rear} <- [{0, 0}, {3, 7}, {49, 1}, {120, 75}] do
+          padded = Audio.pad(audio(x), front, rear, unquote(mode))
+          assert to_list(padded.wave, "<f4") == pad(x, front, rear, unquote(name))
+        end
+      end
+    end
+
+    test "center frames reflect over a wave shorter than half the window" do
+      x = to_list(npy(signal(150)))
+      frames = Audio.to_frames(audio(x), 160, 400, true, "<f4")
+
+      assert rows(frames) == frames(x, 400, 160)
+    end
+  end
+
+  describe "layout" do
+    setup %{tmp_dir: dir} do
+      path = wav_file(dir, stereo3(3000))
+      {:ok, audio} = Audio.load(path)
+      {:ok, path: path, channels: to_list(audio.wave, "<f4") |> Enum.chunk_every(3) |> transpose()}
+    end
+
+    test "selects a channel", %{path: path, channels: channels} do
+      for c <- 0..2 do
+        {:ok, audio} = Audio.load(path, layout: {:channel, c})
+        assert audio.channels == 1
+        assert audio.wave == f32(Enum.at(channels, c))
+      end
+    end
+
+    test "downmixes to the mean of the channels", %{path: path, channels: channels} do
+      {:ok, audio} = Audio.load(path, layout: :mono)
+      mean = Enum.zip_with(channels, &(Enum.sum(&1)/3))
+
+      assert audio.channels == 1
+      assert max_diff(to_list(audio.wave, "<f4"), mean) <= 1.0e-6
+    end
+
+    test "splits the channels", %{path: path, channels: channels} do
+      {:ok, split} = Audio.load(path, layout: :split)
+
+      assert Enum.map(split, & &1.wave) == Enum.map(channels, &f32/1)
+      assert Enum.all?(split, &(&1.channels == 1 and &1.sampling == 16000))
+    end
+
+    test "rejects a channel beyond the file", %{path: path} do
+      assert Audio.load(path, layout: {:channel, 3}) == {:error, :invalid_channel}
+    end
+  end
+
+  describe "offset/duration" do
+    setup %{tmp_dir: dir} do
+      path = wav_file(dir, stereo3(16000))
+      {:ok, audio} = Audio.load(path)
+      {:ok, path: path, audio: audio}
+    end
+
+    test "loads the range in frames", %{audio: audio, path: path} do
+      {:ok, part} = Audio.load(path, offset: 1000, duration: 2345)
+      assert part.wave == frames_of(audio, 1000, 2345)
+
+      {:ok, part} = Audio.load(path, offset: 15000)
+      assert part.wave == frames_of(audio, 15000, 1000)
+
+      {:ok, part} = Audio.load(path, duration: 10)
+      assert part.wave == frames_of(audio, 0, 10)
+    end
+
+    test "loads the range in seconds", %{audio: audio, path: path} do
+      {:ok, part} = Audio.load(path, offset: 0.25, duration: 0.5)
+
+      assert part.wave == frames_of(audio, 4000, 8000)
+    end
+
+    test "clips the range to the file", %{audio: audio, path: path} do
+      {:ok, part} = Audio.load(path, offset: 12000, duration: 10000)
+      assert part.wave == frames_of(audio, 12000, 4000)
+
+      {:ok, part} = Audio.load(path, offset: 20000)
+      assert part.wave == <<>>
+    end
+
+    test "decodes the same range from the image", %{audio: audio} do
+      {:ok, image} = Audio.encode(audio)
+
+      assert Audio.decode(image, offset: 0.5, duration: 100, layout: {:channel, 1}) ==
+             Audio.decode(image, layout: {:channel, 1}) |> then(fn {:ok, a} -> {:ok, %{a | wave: binary_part(a.wave, 8000*4, 100*4)}} end)
+    end
+  end
+
+  describe "write formats" do
+    for {format, tol} <- [s16: 1.0e-4, s24: 1.0e-6, f32: 0.0] do
+      test "reads back what is saved in #{format}", %{tmp_dir: dir} do
+        audio = stereo3(5000)
+        {:ok, back} = Audio.load(wav_file(dir, audio, format: unquote(format)))
+
+        assert {back.channels, back.sampling} == {3, 16000}
+        assert max_diff(to_list(back.wave, "<f4"), to_list(audio.wave, "<f4")) <= unquote(tol)
+      end
+
+      test "streams the chunks to the same file as save in #{format}", %{tmp_dir: dir} do
+        audio = stereo3(5000)
+        path = Path.join(dir, "stream.wav")
+        chunks = for <<chunk::binary-size(1000*3*4) <- audio.wave>>, do: %Audio{audio | wave: chunk}
+
+        assert Audio.Writer.stream_to(chunks, path, 3, 16000, format: unquote(format)) == :ok
+        assert File.read!(path) == File.read!(wav_file(dir, audio, format: unquote(format)))
+      end
+    end
+
+    test "clips the integer formats to full scale", %{tmp_dir: dir} do
+      audio = audio([1.5, -1.5, 0.5])
+
+      for format <- [:s16, :s24] do
+        {:ok, back} = Audio.load(wav_file(dir, audio, format: format))
+        assert max_diff(to_list(back.wave, "<f4"), [1.0, -1.0, 0.5]) <= 1.0e-4
+      end
+    end
+
+    test "rejects a partial frame", %{tmp_dir: dir} do
+      partial = %Audio{channels: 3, sampling: 16000, wave: f32([0.1, 0.2])}
+
+      assert_raise ArgumentError, fn -> Audio.save(partial, Path.join(dir, "partial.wav")) end
+      assert_raise ArgumentError, fn -> Audio.encode(partial) end
+    end
+  end
+end
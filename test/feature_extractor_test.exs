@@ -0,0 +1,150 @@
+defmodule Mozu.FeatureExtractorTest do
+  use ExUnit.Case, async: true
+  import Mozu.TestHelper
+  alias Mozu.FeatureExtractor
+
+  setup do
+    {:ok, fe: FeatureExtractor.new(n_fft: 400, hop: 160, n_mels: 40)}
+  end
+
+  describe "normalize" do
+    setup %{fe: fe} do
+      # a loud half and a half 100 dB below: every clamp takes effect.
+      x = signal(3000) ++ Enum.map(signal(3000, 2), &(&1*1.0e-5))
+      log10 = to_list(FeatureExtractor.log_mel_spectrogram(fe, audio(x), true, "<f8", :log10))
+      {:ok, x: x, log10: log10, max: Enum.max(log10)}
+    end
+
+    defp normalized(fe, x, normalize),
+      do: to_list(FeatureExtractor.log_mel_spectrogram(fe, audio(x), true, "<f8", normalize))
+
+    test "whisper clamps to max - 8 and rescales", %{fe: fe, x: x, log10: log10, max: max} do
+      expected = Enum.map(log10, &((max(&1, max - 8.0) + 4.0)/4.0))
+
+      assert Enum.min(log10) < max - 8.0
+      assert max_diff(normalized(fe, x, :whisper), expected) <= 1.0e-9
+    end
+
+    test "db scales by 10 and clamps to max - top_db", %{fe: fe, x: x, log10: log10, max: max} do
+      db = Enum.map(log10, &(10.0*&1))
+
+      assert max_diff(normalized(fe, x, {:db, nil}), db) <= 1.0e-8
+      assert max_diff(normalized(fe, x, {:db, 40.0}), Enum.map(db, &max(&1, 10.0*max - 40.0))) <= 1.0e-8
+      assert normalized(fe, x, :db) == normalized(fe, x, {:db, 80.0})
+    end
+
+    test "kaldi takes ln with the float32 epsilon floor", %{fe: fe, x: x, log10: log10} do
+      eps = 1.1920928955078125e-7
+      expected = Enum.map(log10, &:math.log(max(:math.pow(10.0, &1), eps)))
+
+      assert max_diff(normalized(fe, x, :kaldi), expected) <= 1.0e-6
+    end
+
+    test "float32 follows float64", %{fe: fe, x: x} do
+      for normalize <- [:log10, :whisper, :db, :kaldi] do
+        f4 = to_list(FeatureExtractor.log_mel_spectrogram(fe, audio(x), true, "<f4", normalize))
+        assert max_diff(f4, normalized(fe, x, normalize)) <= 1.0e-3*max(1.0, Enum.max(Enum.map(f4, &abs/1))), "#{inspect normalize}"
+      end
+    end
+
+    test "rejects an unknown convention", %{fe: fe, x: x} do
+      assert_raise ArgumentError, fn -> normalized(fe, x, :ln) end
+      assert_raise ArgumentError, fn -> normalized(fe, x, {:db, -1.0}) end
+    end
+  end
+
+  describe "mfcc" do
+    # orthonormal DCT-II of the column, as scipy.fft.dct(norm: "ortho").
+    defp dct_ortho(column, n_mfcc) do
+      n = length(column)
+      indexed = Enum.with_index(column)
+      for k <- 0..(n_mfcc - 1) do
+        scale = if k == 0, do: :math.sqrt(1/n), else: :math.sqrt(2/n)
+        scale*Enum.reduce(indexed, 0.0, fn {x, j}, acc -> acc + x*:math.cos(:math.pi()*k*(2*j + 1)/(2*n)) end)
+      end
+    end
+
+    # regression delta over +-width frames, the edges replicated.
+    defp delta(row, width) do
+      at = List.to_tuple(row)
+      last = tuple_size(at) - 1
+      denom = Enum.sum(for n <- 1..width, do: 2*n*n)
+      for t <- 0..last do
+        Enum.sum(for n <- 1..width, do: n*(elem(at, min(t + n, last)) - elem(at, max(t - n, 0))))/denom
+      end
+    end
+
+    setup %{fe: fe} do
+      x = audio(signal(4000))
+      log_mel = FeatureExtractor.log_mel_spectrogram(fe, x, true, "<f8", :db)
+      {:ok, x: x, reference: rows(log_mel) |> transpose() |> Enum.map(&dct_ortho(&1, 13)) |> transpose()}
+    end
+
+    test "is the orthonormal DCT-II of the log mel spectrogram", %{fe: fe, x: x, reference: reference} do
+      mfcc = FeatureExtractor.mfcc(fe, x)
+
+      assert mfcc.descr == "<f4"
+      assert mfcc.shape == {13, length(hd(reference))}
+      assert_close(to_list(mfcc), List.flatten(reference), 1.0e-3)
+    end
+
+    test "lifters the coefficients", %{fe: fe, x: x, reference: reference} do
+      lifter = 22
+      expected = reference
+        |> Enum.with_index()
+        |> Enum.map(fn {row, k} ->
+          lift = 1 + lifter/2*:math.sin(:math.pi()*(k + 1)/lifter)
+          Enum.map(row, &(lift*&1))
+        end)
+
+      assert_close(to_list(FeatureExtractor.mfcc(fe, x, lifter: lifter)), List.flatten(expected), 1.0e-3)
+    end
+
+    test "stacks the deltas below the coefficients", %{fe: fe, x: x} do
+      mfcc = FeatureExtractor.mfcc(fe, x, n_mfcc: 20, deltas: 2, width: 3)
+      {coefs, deltas} = Enum.split(rows(mfcc), 20)
+      {d1, d2} = Enum.split(deltas, 20)
+
+      assert mfcc.shape == {60, length(hd(coefs))}
+      assert rows(FeatureExtractor.mfcc(fe, x, n_mfcc: 20)) == coefs
+      assert_close(List.flatten(d1), Enum.flat_map(coefs, &delta(&1, 3)), 1.0e-5)
+      assert_close(List.flatten(d2), Enum.flat_map(d1, &delta(&1, 3)), 1.0e-5)
+    end
+  end
+
+  describe "log_mel_batch" do
+    # shorter, equal and longer than n_samples; %Audio{} or float32 binary.
+    setup do
+      {:ok, clips: [signal(3000, 1), signal(4000, 2), signal(5500, 3)], n_samples: 4000}
+    end
+
+    defp fit(clip, n_samples), do: Enum.take(clip ++ List.duplicate(0.0, n_samples), n_samples)
+
+    for dtype <- ["<f4", "<f8"], center <- [true, false] do
+      test "gives the spectrogram of each fitted clip #{dtype} center=#{center}", %{fe: fe, clips: clips, n_samples: n_samples} do
+        clips = Enum.map(clips, &audio/1)
+        batch = FeatureExtractor.log_mel_batch(fe, clips, n_samples, dtype: unquote(dtype), center: unquote(center))
+
+        expected = for clip <- clips do
+          fitted = audio(fit(to_list(clip.wave, "<f4"), n_samples))
+          FeatureExtractor.log_mel_spectrogram(fe, fitted, unquote(center), unquote(dtype))
+        end
+
+        {n_mels, n_frames} = hd(expected).shape
+        assert batch.descr == unquote(dtype)
+        assert batch.shape == {3, n_mels, n_frames}
+        assert batch.data == Enum.map_join(expected, & &1.data)
+      end
+    end
+
+    test "takes float32 binaries and the normalization", %{fe: fe, clips: clips, n_samples: n_samples} do
+      batch = FeatureExtractor.log_mel_batch(fe, Enum.map(clips, &f32/1), n_samples, normalize: :whisper)
+
+      expected = for clip <- clips do
+        FeatureExtractor.log_mel_spectrogram(fe, audio(fit(clip, n_samples)), true, "<f4", :whisper).data
+      end
+
+      assert batch.data == Enum.join(expected)
+    end
+  end
+end
@@ -0,0 +1,56 @@
+defmodule Mozu.FFTTest do
+  use ExUnit.Case, async: true
+  import Mozu.TestHelper
+  alias Mozu.FFT
+
+  describe "rfft native backend" do
+    # power of two, 3*5*2^k (mixed radix) and primes (Bluestein).
+    for n <- [256, 1024, 480, 960, 997, 4099], dtype <- ["<f4", "<f8"] do
+      test "matches pocketfft at n=#{n} #{dtype}" do
+        x = npy(signal(unquote(n)))
+        native = FFT.rfft(x, dtype: unquote(dtype), backend: :native)
+        pocket = FFT.rfft(x, dtype: unquote(dtype), backend: :pocketfft)
+
+        assert native.descr == pocket.descr
+        assert native.shape == {div(unquote(n), 2) + 1}
+        assert_close(to_list(native), to_list(pocket), if(unquote(dtype) == "<f4", do: 1.0e-5, else: 1.0e-10))
+      end
+    end
+
+    test "gives the same spectrum from the cached engine" do
+      x = npy(signal(997))
+      first = FFT.rfft(x, backend: :native)
+
+      assert FFT.rfft(x, backend: :native) == first
+    end
+  end
+
+  describe "rfft of frames" do
+    for dtype <- ["<f4", "<f8"], power <- [nil, :norm] do
+      test "gives the rfft of each row #{dtype} #{power}" do
+        # float32 samples: the rows hold the same values in either dtype.
+        x = to_list(npy(signal(7*256)))
+        frames = %{npy(x, unquote(dtype)) | shape: {7, 256}}
+        tol = if unquote(dtype) == "<f4", do: 1.0e-5, else: 1.0e-12
+        spectra = FFT.rfft(frames, power: unquote(power))
+
+        assert spectra.shape == {7, 129}
+        for {frame, spectrum} <- Enum.zip(Enum.chunk_every(x, 256), rows(spectra)) do
+          expected = FFT.rfft(npy(frame), power: unquote(power))
+          assert_close(spectrum, to_list(expected), tol)
+        end
+      end
+    end
+
+    test "gives the same spectrum for any cap of threads" do
+      # 600 frames: several blocks of the pool unless capped.
+      frames = %{npy(signal(600*256)) | shape: {600, 256}}
+      whole = FFT.rfft(frames, power: :norm)
+
+      assert whole.shape == {600, 129}
+      for nthreads <- [1, 2, 3, 64] do
+        assert FFT.rfft(frames, power: :norm, nthreads: nthreads) == whole
+      end
+    end
+  end
+end
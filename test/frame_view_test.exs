@@ -0,0 +1,54 @@
+defmodule Mozu.FrameViewTest do
+  use ExUnit.Case, async: true
+  import Mozu.TestHelper
+  alias Mozu.{Audio, FFT, FeatureExtractor, FrameView}
+
+  describe "to_frames" do
+    test "includes the last frame ending at the end of the wave" do
+      x = signal(400 + 4*160)
+      frames = Audio.to_frames(audio(x), 160, 400, false, "<f4")
+
+      assert frames.shape == {5, 400}
+      assert List.last(rows(frames)) == to_list(npy(Enum.take(x, -400)))
+    end
+
+    test "reflect pads by half the window with center" do
+      x = signal(1000)
+      frames = Audio.to_frames(audio(x), 160, 400, true, "<f8")
+
+      # the float32 samples are exact in float64.
+      expected = frames(to_list(npy(x)), 400, 160)
+      assert frames.shape == {length(expected), 400}
+      assert rows(frames) == expected
+    end
+  end
+
+  describe "FrameView" do
+    for center <- [true, false] do
+      test "materializes as to_frames center=#{center}" do
+        a = audio(signal(1234))
+        view = FrameView.new(a, 160, 400, unquote(center))
+        frames = Audio.to_frames(a, 160, 400, unquote(center), "<f4")
+
+        assert FrameView.shape(view) == frames.shape
+        assert FrameView.to_npy(view, "<f4") == frames
+      end
+
+      test "gives the spectra of the materialized frames center=#{center}" do
+        a = audio(signal(1234))
+        view = FrameView.new(a, 160, 400, unquote(center))
+        frames = Audio.to_frames(a, 160, 400, unquote(center), "<f4")
+
+        assert_close(to_list(FFT.rfft(view, power: :norm)), to_list(FFT.rfft(frames, power: :norm)), 1.0e-6)
+      end
+    end
+
+    test "gives the log mel spectrogram of the audio" do
+      a = audio(signal(4000))
+      fe = FeatureExtractor.new(n_fft: 400, hop: 160, n_mels: 40)
+
+      assert FeatureExtractor.log_mel_spectrogram(fe, FrameView.new(a, 160, 400, true), true, "<f4") ==
+             FeatureExtractor.log_mel_spectrogram(fe, a, true, "<f4")
+    end
+  end
+end
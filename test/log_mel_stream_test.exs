@@ -0,0 +1,51 @@
+defmodule Mozu.LogMelStreamTest do
+  use ExUnit.Case, async: true
+  import Mozu.TestHelper
+  alias Mozu.{FeatureExtractor, LogMelStream}
+
+  setup do
+    {:ok, fe: FeatureExtractor.new(n_fft: 400, hop: 160, n_mels: 40), x: signal(6000)}
+  end
+
+  # chunks of the sizes in turn: below n_fft/2+1, across a hop and longer.
+  defp chunks(list, sizes) do
+    Stream.cycle(sizes)
+    |> Enum.reduce_while({list, []}, fn
+      _, {[], acc} -> {:halt, Enum.reverse(acc)}
+      size, {rest, acc} ->
+        {chunk, rest} = Enum.split(rest, size)
+        {:cont, {rest, [audio(chunk) | acc]}}
+    end)
+  end
+
+  # the {n_mels, k} spectrograms joined along the frames.
+  defp hstack(mels) do
+    mels
+    |> Enum.reject(&match?(%{shape: {_, 0}}, &1))
+    |> Enum.map(&rows/1)
+    |> Enum.zip_with(&Enum.concat/1)
+  end
+
+  for center <- [true, false], normalize <- [:log10, :kaldi, {:db, nil}] do
+    test "gives the frames of the whole wave center=#{center} #{inspect normalize}", %{fe: fe, x: x} do
+      whole = FeatureExtractor.log_mel_spectrogram(fe, audio(x), unquote(center), "<f4", unquote(Macro.escape(normalize)))
+      {:ok, stream} = LogMelStream.open(fe, center: unquote(center), normalize: unquote(Macro.escape(normalize)))
+
+      pushed = for chunk <- chunks(x, [1, 7, 160, 199, 201, 1000]) do
+        {:ok, mel} = LogMelStream.push(stream, chunk)
+        mel
+      end
+      {:ok, tail} = LogMelStream.flush(stream)
+
+      assert_close(List.flatten(hstack(pushed ++ [tail])), to_list(whole), 1.0e-6)
+    end
+  end
+
+  test "stream/3 gives the frames of the whole wave", %{fe: fe, x: x} do
+    whole = FeatureExtractor.log_mel_spectrogram(fe, audio(x), true, "<f4", :log10)
+    mels = chunks(x, [512]) |> LogMelStream.stream(fe) |> Enum.to_list()
+
+    assert Enum.all?(mels, &(elem(&1.shape, 0) == 40))
+    assert_close(List.flatten(hstack(mels)), to_list(whole), 1.0e-6)
+  end
+end
@@ -1,8 +1,47 @@
 defmodule MozuTest do
-  use ExUnit.Case
+  use ExUnit.Case, async: true
+  import Mozu.TestHelper
   doctest Mozu
 
-  test "greets the world" do
-    assert Mozu.hello() == :world
+  # log10 mel spectrogram by the definition: reflect padded frames, Hann
+  # window, |DFT|^2 and the slaney filter bank, in float64.
+  defp reference_log_mel(x, n_fft, hop, n_mels) do
+    window = to_list(Mozu.Audio.hanning(n_fft))
+    bank = Mozu.mel_filter_bank(div(n_fft, 2) + 1, n_mels, 0.0, 8000.0, 16000, :slaney, true) |> rows() |> transpose()
+
+    spectra = for frame <- frames(x, n_fft, hop), do: power_spectrum(Enum.zip_with(frame, window, &(&1*&2)))
+
+    for filter <- bank do
+      for spectrum <- spectra, do: :math.log10(max(dot(spectrum, filter), 1.0e-10))
+    end
+  end
+
+  describe "log_mel_spectrogram" do
+    setup do
+      x = signal(2000)
+      {:ok, x: x, reference: reference_log_mel(x, 400, 160, 40)}
+    end
+
+    test "matches the reference in float64", %{x: x, reference: reference} do
+      mel = Mozu.log_mel_spectrogram(audio(x), n_mels: 40)
+
+      assert mel.descr == "<f8"
+      assert mel.shape == {40, 13}
+      assert max_diff(to_list(mel), List.flatten(reference)) <= 1.0e-6
+    end
+
+    test "matches the reference in float32", %{x: x, reference: reference} do
+      mel = Mozu.log_mel_spectrogram(audio(x), n_mels: 40, dtype: "<f4")
+
+      assert mel.descr == "<f4"
+      assert mel.shape == {40, 13}
+      assert max_diff(to_list(mel), List.flatten(reference)) <= 1.0e-3
+    end
+
+    test "takes the floor of 1e-10 on silence" do
+      mel = Mozu.log_mel_spectrogram(audio(List.duplicate(0.0, 1600)), n_mels: 40)
+
+      assert Enum.all?(to_list(mel), &(&1 == -10.0))
+    end
   end
 end
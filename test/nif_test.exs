@@ -0,0 +1,113 @@
+defmodule Mozu.NIFTest do
+  # every public wrapper once: a NIF missing from the table or registered
+  # with another arity fails here with UndefinedFunctionError.
+  use ExUnit.Case, async: false
+  import Mozu.TestHelper
+  alias Mozu.{Async, Audio, FeatureExtractor, FFT, FrameView, LogMelStream, MelBank, Resampler, Util}
+
+  @moduletag :tmp_dir
+
+  defp ok!({:ok, result}), do: result
+  defp ok!(:ok), do: :ok
+  defp ok!(%{} = result), do: result
+
+  setup do
+    {:ok, x: audio(signal(2000)), fe: FeatureExtractor.new(n_fft: 400, hop: 160, n_mels: 40)}
+  end
+
+  test "Mozu", %{x: x} do
+    ok!(Mozu.mel_filter_bank(201, 40, 0.0, 8000.0, 16000, :slaney, true))
+    ok!(Mozu.log_mel_spectrogram(x, n_mels: 40))
+    ok!(Mozu.mfcc(x, n_mels: 40))
+    ok!(Mozu.hz2mel(npy([1000.0], "<f8"), :slaney))
+    ok!(Mozu.mel2hz(npy([15.0], "<f8"), :slaney))
+  end
+
+  test "Mozu.Audio", %{x: x, tmp_dir: tmp_dir} do
+    path = Path.join(tmp_dir, "a.wav")
+    :ok = Audio.save(x, path)
+    ok!(Audio.load(path))
+    ok!(Audio.decode(ok!(Audio.encode(x))))
+    ok!(Audio.resample(x, 8000))
+    ok!(Audio.to_frames(x))
+    ok!(Audio.pad(x, 2, 2))
+    ok!(Audio.hanning(400))
+    ok!(Audio.hamming(400))
+
+    reader = ok!(Audio.Reader.open(path))
+    ok!(Audio.Reader.read_chunk(reader, 100))
+    ok!(Audio.Reader.seek(reader, 0))
+    ok!(Audio.Reader.close(reader))
+
+    writer = ok!(Audio.Writer.open(Path.join(tmp_dir, "b.wav"), 1, 16000))
+    ok!(Audio.Writer.write(writer, x))
+    ok!(Audio.Writer.close(writer))
+  end
+
+  test "Mozu.FeatureExtractor and Mozu.LogMelStream", %{x: x, fe: fe} do
+    ok!(FeatureExtractor.log_mel_spectrogram(fe, x))
+    ok!(FeatureExtractor.mfcc(fe, x))
+    ok!(FeatureExtractor.log_mel_batch(fe, [x], 2000))
+
+    stream = ok!(LogMelStream.open(fe))
+    ok!(LogMelStream.push(stream, x))
+    ok!(LogMelStream.flush(stream))
+  end
+
+  test "Mozu.FFT and Mozu.MelBank", %{x: x} do
+    spectrum = ok!(FFT.rfft(npy(signal(400))))
+    ok!(FFT.power(spectrum, :norm))
+    power = ok!(FFT.rfft(%{npy(signal(800)) | shape: {2, 400}}, power: :norm))
+    ok!(FFT.rfft(FrameView.new(x)))
+    ok!(FrameView.to_npy(FrameView.new(x)))
+
+    plan = ok!(FFT.Plan.new(400))
+    ok!(FFT.Plan.rfft(plan, npy(signal(400), "<f8")))
+
+    bank = ok!(MelBank.new(201, 40, 0.0, 8000.0, 16000))
+    ok!(MelBank.to_dense(bank))
+    ok!(MelBank.apply_to(bank, power))
+  end
+
+  test "Mozu.Resampler and Mozu.Util", %{x: x} do
+    resampler = ok!(Resampler.open(1, 16000, 8000))
+    ok!(Resampler.push(resampler, x))
+    ok!(Resampler.flush(resampler))
+
+    ok!(Util.astype(npy(signal(10)), "<f8"))
+    ok!(Util.linspace(0.0, 1.0, 5))
+    {:ok, _, _} = Util.simd_info()
+    ok!(Util.simd_backend(:auto))
+    ok!(Util.thread_pool(ok!(Util.thread_pool_info())))
+  end
+
+  test "Mozu.Async and every job it takes", %{x: x, fe: fe, tmp_dir: tmp_dir} do
+    path = Path.join(tmp_dir, "a.wav")
+    :ok = Audio.save(x, path)
+    image = ok!(Audio.encode(x))
+    spectrum = FFT.rfft(npy(signal(400)))
+    frames = %{npy(signal(800)) | shape: {2, 400}}
+    bank = MelBank.new(201, 40, 0.0, 8000.0, 16000)
+    power = FFT.rfft(frames, power: :norm)
+
+    jobs = [
+      Async.load(path),
+      Async.log_mel_spectrogram(fe, x),
+      Async.mfcc(fe, x),
+      Async.submit(:wav_decode, [image, :interleaved, nil, nil]),
+      Async.submit(:resample, [x.wave, 1, 16000, 8000]),
+      Async.submit(:log_mel_batch, [fe.ref, [x.wave], 2000, true, "<f4", :log10]),
+      Async.submit(:rfft_2D, [frames.data, "<f4", 400, 400, false, :norm, 0]),
+      Async.submit(:power, [spectrum.data, spectrum.descr, :norm]),
+      Async.submit(:mel_apply, [bank.ref, power.data, power.descr]),
+      Async.submit(:astype, [npy(signal(10)).data, "<f4", "<f8"])
+    ]
+
+    for job <- jobs do
+      assert {:ok, _} = Async.await(ok!(job), 5000)
+    end
+
+    {:ok, {_, _, runners, capacity}} = Async.info()
+    ok!(Async.configure(runners: runners, capacity: capacity))
+  end
+end
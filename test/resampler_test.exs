@@ -0,0 +1,39 @@
+defmodule Mozu.ResamplerTest do
+  use ExUnit.Case, async: true
+  import Mozu.TestHelper
+  alias Mozu.{Audio, Resampler}
+
+  defp chunks(%Audio{channels: channels, wave: wave} = audio, sizes) do
+    {chunks, rest} = Enum.map_reduce(sizes, wave, fn size, rest ->
+      <<chunk::binary-size(size*channels*4), rest::binary>> = rest
+      {%Audio{audio | wave: chunk}, rest}
+    end)
+    chunks ++ [%Audio{audio | wave: rest}]
+  end
+
+  for {from, to} <- [{44100, 16000}, {16000, 48000}, {22050, 16000}] do
+    test "chunked output equals the one-shot output #{from} -> #{to}" do
+      audio = audio(signal(20_000), unquote(from))
+      whole = Audio.resample(audio, unquote(to))
+
+      {:ok, resampler} = Resampler.open(1, unquote(from), unquote(to))
+      pushed = for chunk <- chunks(audio, [1, 999, 4096, 7, 5000]) do
+        {:ok, out} = Resampler.push(resampler, chunk)
+        out.wave
+      end
+      {:ok, tail} = Resampler.flush(resampler)
+
+      assert IO.iodata_to_binary([pushed, tail.wave]) == whole.wave
+      assert abs(Audio.length(whole) - 20_000*unquote(to)/unquote(from)) <= 1
+    end
+  end
+
+  test "streams interleaved stereo as the one-shot" do
+    wave = Enum.zip_with(signal(12_000, 1), signal(12_000, 2), &[&1, &2]) |> List.flatten()
+    audio = %Audio{channels: 2, sampling: 44100, wave: f32(wave)}
+
+    streamed = chunks(audio, [3000, 3000, 3000]) |> Resampler.stream(16000) |> Enum.map_join(& &1.wave)
+
+    assert streamed == Audio.resample(audio, 16000).wave
+  end
+end
@@ -0,0 +1,58 @@
+defmodule Mozu.SimdTest do
+  # the kernels are switched process-wide.
+  use ExUnit.Case, async: false
+  import Mozu.TestHelper
+  alias Mozu.{FFT, FeatureExtractor, Util}
+
+  setup do
+    on_exit(fn -> Util.simd_backend(:auto) end)
+  end
+
+  # every kernel over lengths that leave a scalar tail on each vector width.
+  defp run_kernels() do
+    x = signal(203)
+    spectrum = %{npy(x ++ Enum.reverse(x)) | descr: "<c8", shape: {203}}
+    spectrum64 = %{npy(x ++ Enum.reverse(x), "<f8") | descr: "<c16", shape: {203}}
+    # halfway, out of range and non-finite values must round and saturate alike.
+    edges = [0.5, 1.5, 2.5, -2.5, 1.7, -1.7, 2.147483647e9, 2.147483648e9, 3.0e9, -3.0e9, 1.0e30, -1.0e30]
+    ints = Enum.map(x, &(&1*1000.0)) ++ edges
+
+    # a silent half gives the log of the floor in whole vectors and in the tail.
+    silence = audio(signal(3000) ++ List.duplicate(0.0, 3000))
+    fe = FeatureExtractor.new(n_fft: 400, hop: 160, n_mels: 80)
+
+    [
+      abs_f4: FFT.power(spectrum, :abs),
+      abs_f8: FFT.power(spectrum64, :abs),
+      norm_f4: FFT.power(spectrum, :norm),
+      norm_f8: FFT.power(spectrum64, :norm),
+      f4_to_f8: Util.astype(npy(x), "<f8"),
+      f8_to_f4: Util.astype(npy(x, "<f8"), "<f4"),
+      f4_to_i4: Util.astype(npy(ints), "<i4"),
+      f8_to_i4: Util.astype(npy(ints, "<f8"), "<i4"),
+      log10_f4: FeatureExtractor.log_mel_spectrogram(fe, silence, true, "<f4", :log10)
+    ]
+  end
+
+  test "every supported kernel agrees with the scalar one" do
+    {:ok, _, supported} = Util.simd_info()
+
+    {:ok, :scalar} = Util.simd_backend(:scalar)
+    reference = run_kernels()
+
+    for name <- supported, name != :scalar do
+      {:ok, ^name} = Util.simd_backend(name)
+
+      for {{kernel, result}, {kernel, expected}} <- Enum.zip(run_kernels(), reference) do
+        assert result.descr == expected.descr, "#{name} #{kernel}"
+        assert result.shape == expected.shape, "#{name} #{kernel}"
+
+        if String.ends_with?(Atom.to_string(kernel), "i4") do
+          assert result.data == expected.data, "#{name} #{kernel}"
+        else
+          assert max_diff(to_list(result), to_list(expected)) <= 1.0e-4, "#{name} #{kernel}"
+        end
+      end
+    end
+  end
+end
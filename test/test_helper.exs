@@ -1 +1,104 @@
 ExUnit.start()
+
+defmodule Mozu.TestHelper do
+  @moduledoc false
+
+  @doc "float32 binary of the list."
+  def f32(list), do: for(x <- list, into: <<>>, do: <<x::float-32-little>>)
+
+  @doc "float64 binary of the list."
+  def f64(list), do: for(x <- list, into: <<>>, do: <<x::float-64-little>>)
+
+  @doc "mono %Mozu.Audio{} of the list."
+  def audio(list, sampling \\ 16000), do: %Mozu.Audio{channels: 1, sampling: sampling, wave: f32(list)}
+
+  @doc "1D %Npy{} of the list."
+  def npy(list, descr \\ "<f4") do
+    data = if descr == "<f4", do: f32(list), else: f64(list)
+    %{__struct__: Npy, descr: descr, fortran_order: false, shape: {length(list)}, data: data}
+  end
+
+  @doc "a few sines, deterministic test signal of n samples."
+  def signal(n, seed \\ 1) do
+    for i <- 0..(n - 1)//1 do
+      0.5*:math.sin(0.031*seed*i) + 0.3*:math.sin(0.17*i + seed) + 0.1*:math.cos(1.3*i)
+    end
+  end
+
+  @doc "elements of the binary; complex dtypes give re, im, re, im, ..."
+  def to_list(%{descr: descr, data: data}), do: to_list(data, descr)
+
+  def to_list(data, descr) when descr in ["<f4", "<c8"], do: for(<<x::float-32-little <- data>>, do: x)
+  def to_list(data, descr) when descr in ["<f8", "<c16"], do: for(<<x::float-64-little <- data>>, do: x)
+  def to_list(data, "<f2"), do: for(<<x::float-16-little <- data>>, do: x)
+  def to_list(data, "<i4"), do: for(<<x::signed-32-little <- data>>, do: x)
+  def to_list(data, "<u4"), do: for(<<x::unsigned-32-little <- data>>, do: x)
+  def to_list(data, "<i2"), do: for(<<x::signed-16-little <- data>>, do: x)
+  def to_list(data, "<u1"), do: for(<<x::unsigned-8 <- data>>, do: x)
+
+  @doc "list padded like numpy.pad in mode :zero, :edge or :reflect."
+  def pad(list, front, rear, mode) do
+    n = length(list)
+    at = List.to_tuple(list)
+    sample = fn i ->
+      cond do
+        i >= 0 and i < n -> elem(at, i)
+        mode == :zero -> 0.0
+        mode == :edge -> elem(at, if(i < 0, do: 0, else: n - 1))
+        mode == :reflect ->
+          period = 2*(n - 1)
+          j = Integer.mod(i, period)
+          elem(at, if(j < n, do: j, else: period - j))
+      end
+    end
+    for i <- -front..(n + rear - 1)//1, do: sample.(i)
+  end
+
+  @doc "frames of the list; center reflect pads window/2 at both ends."
+  def frames(list, window, hop, center \\ true) do
+    half = if center, do: div(window, 2), else: 0
+    padded = pad(list, half, half, :reflect)
+    Enum.chunk_every(padded, window, hop, :discard)
+  end
+
+  @doc "|DFT|^2 of the frame by the definition, bins 0..n/2."
+  def power_spectrum(frame) do
+    n = length(frame)
+    indexed = Enum.with_index(frame)
+    for k <- 0..div(n, 2) do
+      {re, im} = Enum.reduce(indexed, {0.0, 0.0}, fn {x, j}, {re, im} ->
+        theta = 2*:math.pi()*rem(j*k, n)/n
+        {re + x*:math.cos(theta), im - x*:math.sin(theta)}
+      end)
+      re*re + im*im
+    end
+  end
+
+  @doc "dot product of two lists."
+  def dot(a, b), do: Enum.zip_with(a, b, &(&1*&2)) |> Enum.sum()
+
+  @doc "transpose of the list of rows."
+  def transpose(rows), do: Enum.zip(rows) |> Enum.map(&Tuple.to_list/1)
+
+  @doc "rows of the 2D %Npy{} as lists; complex elements give re, im pairs."
+  def rows(%{descr: descr, shape: {_, n_cols}} = npy) do
+    width = if descr in ["<c8", "<c16"], do: 2*n_cols, else: n_cols
+    to_list(npy) |> Enum.chunk_every(width)
+  end
+
+  @doc "largest elementwise difference of two lists."
+  def max_diff(a, b) when length(a) == length(b) do
+    Enum.zip_with(a, b, fn x, y -> abs(x - y) end) |> Enum.max(fn -> 0.0 end)
+  end
+
+  @doc "asserts the lists agree within tol times their largest magnitude."
+  defmacro assert_close(a, b, tol) do
+    quote do
+      a = unquote(a)
+      b = unquote(b)
+      assert length(a) == length(b)
+      scale = Enum.reduce(b, 1.0e-30, &max(abs(&1), &2))
+      assert Mozu.TestHelper.max_diff(a, b) <= unquote(tol)*scale
+    end
+  end
+end
@@ -0,0 +1,47 @@
+defmodule Mozu.UtilTest do
+  use ExUnit.Case, async: true
+  import Mozu.TestHelper
+  alias Mozu.{FFT, Util}
+
+  describe "astype" do
+    @values [1.7, -1.7, 2.5, -2.5, 0.5, 3.0e9, -3.0e9]
+
+    test "rounds to nearest even and saturates for every integer dtype" do
+      assert to_list(Util.astype(npy(@values), "<i4")) == [2, -2, 2, -2, 0, 2_147_483_647, -2_147_483_648]
+      assert to_list(Util.astype(npy(@values), "<u4")) == [2, 0, 2, 0, 0, 3_000_000_000, 0]
+      assert to_list(Util.astype(npy(@values), "<i2")) == [2, -2, 2, -2, 0, 32767, -32768]
+      assert to_list(Util.astype(npy(@values), "<u1")) == [2, 0, 2, 0, 0, 255, 0]
+    end
+
+    test "takes the same rule from float64" do
+      assert to_list(Util.astype(npy(@values, "<f8"), "<i4")) == [2, -2, 2, -2, 0, 2_147_483_647, -2_147_483_648]
+    end
+
+    test "maps NaN and infinities like the range limits" do
+      # NaN and +-inf can not be written by the bit syntax, so build them bitwise.
+      nan = <<0, 0, 192, 127>>
+      inf = <<0, 0, 128, 127>>
+      ninf = <<0, 0, 128, 255>>
+      special = %{__struct__: Npy, descr: "<f4", fortran_order: false, shape: {3}, data: nan <> inf <> ninf}
+
+      assert to_list(Util.astype(special, "<i4")) == [0, 2_147_483_647, -2_147_483_648]
+      assert to_list(Util.astype(special, "<u1")) == [0, 255, 0]
+    end
+
+    test "converts between floats and back" do
+      x = signal(100)
+      assert_close(to_list(Util.astype(Util.astype(npy(x), "<f8"), "<f4")), to_list(npy(x)), 0.0)
+      assert_close(to_list(Util.astype(npy(x), "<f2")), x, 1.0e-3)
+    end
+
+    test "takes a sub-binary at any byte" do
+      x = signal(100)
+      # a part of a refc binary keeps its offset: the data is misaligned for float64.
+      image = <<0>> <> f64(x)
+      shifted = %{npy(x, "<f8") | data: binary_part(image, 1, byte_size(image) - 1)}
+
+      assert Util.astype(shifted, "<f4") == Util.astype(npy(x, "<f8"), "<f4")
+      assert FFT.rfft(%{shifted | shape: {4, 25}}) == FFT.rfft(%{npy(x, "<f8") | shape: {4, 25}})
+    end
+  end
+end